@@ -0,0 +1,163 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// HashLatticePOW throughput benchmark: N threads searching nonces over one
+// round table, reporting H/s per thread and in total.
+//
+// Usage: bench_lattice [threads] [seconds] [pow version] [share bits] [-profile] [-placement=<policy>]
+//
+// Workers report every hash with share bits leading zero bits (default 8),
+// their best hash and hash counts through a CMinerResultChannel to the main
+// thread, so a low share difficulty measures the cost of reporting.
+//
+// With -profile, hardware counters (cycles, instructions, IPC, L1D/LLC and
+// branch misses) are read around every nonce batch and around each
+// HashLatticePOW stage run in isolation, and reported per stage and thread.
+// -placement pins the hashing threads: none, core, smt or numa.
+
+#define GLOBALDEFINED
+#include "hash.h"
+#include "latticeplacement.h"
+#include "latticeprofile.h"
+#include "latticetune.h"
+#include "minerchannel.h"
+#include "util.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+
+static const uint32_t BENCH_BATCH_SIZE = 1024;
+
+int main(int argc, char* argv[])
+{
+    bool fProfile = false;
+    PlacementPolicy placementPolicy = DEFAULT_PLACEMENT_POLICY;
+    std::vector<int> vArgs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-profile") == 0) {
+            fProfile = true;
+        } else if (strncmp(argv[i], "-placement=", 11) == 0) {
+            if (!ParsePlacementPolicy(argv[i] + 11, placementPolicy)) {
+                std::cerr << "Unknown placement policy " << argv[i] + 11 << std::endl;
+                return 1;
+            }
+        } else {
+            vArgs.push_back(atoi(argv[i]));
+        }
+    }
+    int nThreads = vArgs.size() > 0 ? vArgs[0] : 1;
+    int nSeconds = vArgs.size() > 1 ? vArgs[1] : 5;
+    int nVersion = vArgs.size() > 2 ? vArgs[2] : LATTICE_POW_VERSION_SINGLE;
+    int nShareBits = vArgs.size() > 3 ? vArgs[3] : 8;
+
+    if (fProfile && !EnableLatticeProfile()) {
+        std::cerr << "Hardware counters unavailable; check kernel.perf_event_paranoid" << std::endl;
+        fProfile = false;
+    }
+    SetWorkerPlacement(placementPolicy);
+    std::cout << "Lattice backend: " << LatticeAutoTune(DEFAULT_LATTICE_TUNE_FILE) << std::endl;
+
+    uint256 hashPrevBlock = uint256S("0x00000000000000000000000000000000000000000000000000000000deadbeef");
+    LatticeRoundTable table;
+    BuildLatticeRoundTable(hashPrevBlock, nVersion, table);
+
+    arith_uint256 shareTarget = ~arith_uint256(0) >> std::min(std::max(nShareBits, 0), 255);
+    CMinerResultChannel channel(nThreads);
+
+    std::atomic<bool> fStop(false);
+    std::atomic<int> nRunning(nThreads);
+    std::vector<uint64_t> vHashes(nThreads);
+    std::vector<uint64_t> vStalls(nThreads);
+    std::vector<std::string> vPlacement(nThreads);
+    std::vector<std::thread> vThreads;
+    for (int t = 0; t < nThreads; t++) {
+        vThreads.emplace_back([t, &table, &fStop, &nRunning, &channel, &shareTarget, &vHashes, &vStalls, &vPlacement, fProfile] {
+            RenameThread(strprintf("bench-%d", t).c_str());
+            CWorkerPlacement placement;
+            vPlacement[t] = placement.ToString();
+            LatticeRoundTable localTable = table;
+            placement.LocalizeRoundTable(localTable);
+            unsigned char header[80];
+            for (int i = 0; i < 80; i++)
+                header[i] = (unsigned char)(i + t * 80);
+            CMinerReporter reporter(channel, t, shareTarget);
+            uint32_t nNonce = 0;
+            while (!fStop) {
+                CPerfScope scope("hash_batch", BENCH_BATCH_SIZE);
+                for (uint32_t i = 0; i < BENCH_BATCH_SIZE; i++) {
+                    WriteLE32(header + 76, nNonce);
+                    reporter.Hash(header, nNonce, HashLatticePOW(header, header + 80, localTable));
+                    nNonce++;
+                }
+                vHashes[t] += BENCH_BATCH_SIZE;
+            }
+            reporter.Flush();
+            vStalls[t] = reporter.GetStalls();
+            nRunning--;
+            if (fProfile)
+                ProfileLatticeStages(16 * BENCH_BATCH_SIZE);
+        });
+    }
+
+    // The main thread is the submitter
+    uint64_t nShares = 0, nReported = 0;
+    arith_uint256 best = ~arith_uint256(0);
+    std::vector<MinerResult> vResults;
+    auto process = [&] {
+        vResults.clear();
+        channel.Drain(vResults);
+        for (const MinerResult& result : vResults) {
+            if (result.type == MINER_RESULT_SOLUTION) {
+                nShares++;
+            } else if (result.type == MINER_RESULT_BEST) {
+                best = std::min(best, UintToArith256(result.hash));
+            } else {
+                nReported += result.nHashes;
+            }
+        }
+    };
+
+    auto start_time = std::chrono::steady_clock::now();
+    auto stop_time = start_time + std::chrono::seconds(nSeconds);
+    while (std::chrono::steady_clock::now() < stop_time) {
+        channel.WaitForResults(10000);
+        process();
+    }
+    fStop = true;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    while (nRunning > 0) {
+        channel.WaitForResults(1000);
+        process();
+    }
+    for (std::thread& thread : vThreads) {
+        thread.join();
+    }
+    process();
+
+    std::cout << "=== LATTICE-PoW HashLatticePOW Benchmark ===" << std::endl;
+    std::cout << "Threads: " << nThreads << ", PoW version: " << nVersion
+              << ", placement: " << GetPlacementPolicyName(GetWorkerPlacement()) << std::endl;
+    uint64_t nTotal = 0;
+    for (int t = 0; t < nThreads; t++) {
+        std::cout << "Thread " << t << ": " << std::fixed << std::setprecision(2) << vHashes[t] / elapsed << " H/s (" << vPlacement[t] << ")" << std::endl;
+        nTotal += vHashes[t];
+    }
+    std::cout << "Total: " << std::fixed << std::setprecision(2) << nTotal / elapsed << " H/s" << std::endl;
+    uint64_t nStalls = 0;
+    for (uint64_t n : vStalls) {
+        nStalls += n;
+    }
+    std::cout << "Shares (" << nShareBits << " bits): " << nShares << " (" << nShares / elapsed << "/s), "
+              << "hashes reported: " << nReported << ", channel stalls: " << nStalls << std::endl;
+    std::cout << "Best hash: " << ArithToUint256(best).GetHex() << std::endl;
+
+    if (fProfile) {
+        std::cout << std::endl << "Per-item hardware counters:" << std::endl;
+        std::cout << FormatLatticeProfile();
+    }
+    return 0;
+}
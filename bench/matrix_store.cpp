@@ -0,0 +1,100 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Matrix store benchmark: cost of expanding an XOF lattice matrix against
+// publishing it through CLatticeMatrixStore and mapping it back.
+//
+// Usage: matrix_store [-dim=<rows and cols>] [-dir=<store directory>] [-procs=<n>] [-threads=<n>]
+//
+// The parent expands the matrix once cold, then publishes it; -procs child
+// processes each open their own store and map the published file, as other
+// nodes and miners on the host would. Every mapping is compared against the
+// cold expansion.
+
+#define GLOBALDEFINED
+#include "hash.h"
+#include "latticemetrics.h"
+#include "latticestore.h"
+#include "random.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> mapArgs;
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        size_t pos = str.find('=');
+        if (str.size() < 2 || str[0] != '-' || pos == std::string::npos) {
+            std::cerr << "Unexpected argument " << str << std::endl;
+            return 1;
+        }
+        mapArgs[str.substr(1, pos - 1)] = str.substr(pos + 1);
+    }
+    uint32_t nDim = std::max(1, mapArgs.count("dim") ? atoi(mapArgs["dim"].c_str()) : 1024);
+    std::string strDir = mapArgs.count("dir") ? mapArgs["dir"] : DEFAULT_LATTICE_MATRIX_DIR;
+    int nProcs = std::max(0, mapArgs.count("procs") ? atoi(mapArgs["procs"].c_str()) : 4);
+    int nThreads = std::max(1, mapArgs.count("threads") ? atoi(mapArgs["threads"].c_str()) : 1);
+
+    uint256 seed = GetRandHash();
+    std::vector<uint32_t> vExpected((size_t)nDim * nDim);
+    int64_t nStart = MetricNanos();
+    ExpandLatticeMatrixXOF(seed, nDim, nDim, vExpected.data(), nThreads);
+    int64_t nExpandNanos = MetricNanos() - nStart;
+    size_t nBytes = vExpected.size() * sizeof(uint32_t);
+
+    pLatticeMatrixStore.reset(new CLatticeMatrixStore(strDir));
+    if (!pLatticeMatrixStore->Open())
+        return 1;
+    nStart = MetricNanos();
+    std::shared_ptr<const CLatticeMatrixMapping> mapping = GetStoredLatticeMatrixXOF(seed, nDim, nDim, nThreads);
+    int64_t nPublishNanos = MetricNanos() - nStart;
+    if (!mapping || memcmp(mapping->Data(), vExpected.data(), nBytes) != 0) {
+        std::cerr << "Published matrix does not match its expansion" << std::endl;
+        return 2;
+    }
+
+    std::cout << "=== LATTICE-PoW Matrix Store Benchmark ===" << std::endl;
+    std::cout << "Matrix: " << nDim << "x" << nDim << " (" << nBytes / 1024 << " KiB), store: " << strDir
+              << ", processes: " << nProcs << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Expand: " << nExpandNanos / 1e6 << " ms, expand and publish: " << nPublishNanos / 1e6 << " ms" << std::endl;
+    std::cout.flush();
+
+    std::vector<pid_t> vChildren;
+    for (int i = 0; i < nProcs; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "fork failed" << std::endl;
+            break;
+        }
+        if (pid == 0) {
+            CLatticeMatrixStore store(strDir);
+            int64_t nMapStart = MetricNanos();
+            std::shared_ptr<const CLatticeMatrixMapping> childMapping = store.Get(LATTICE_MATRIX_XOF, seed, nDim, nDim,
+                                                                                  [](uint32_t* matrix) {});
+            int64_t nMapNanos = MetricNanos() - nMapStart;
+            bool fOk = childMapping && store.GetWritten() == 0 &&
+                       memcmp(childMapping->Data(), vExpected.data(), nBytes) == 0;
+            std::cout << "Process " << i << ": map and verify " << nMapNanos / 1e6 << " ms"
+                      << (fOk ? "" : ", MISMATCH") << std::endl;
+            _exit(fOk ? 0 : 2);
+        }
+        vChildren.push_back(pid);
+    }
+    int nFailed = 0;
+    for (pid_t pid : vChildren) {
+        int status;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            nFailed++;
+    }
+    return nFailed > 0 ? 2 : 0;
+}
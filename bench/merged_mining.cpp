@@ -0,0 +1,136 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Merged-mining benchmark: one nonce loop over HashLatticePOW serving a
+// parent chain and N auxiliary chains through CMergedMiningWork.
+//
+// Usage: merged_mining [-chains=<n>] [-hashes=<n>] [-bits=<easiest aux target bits>] [-version=<pow version>]
+//
+// Aux chain i needs -bits + i leading zero bits. Every solution routed to a
+// chain is checked with CheckAuxProof, and the cost of CheckHash per parent
+// hash is reported next to the cost of the hash itself.
+
+#define GLOBALDEFINED
+#include "hash.h"
+#include "latticemetrics.h"
+#include "mergedmining.h"
+#include "latticetune.h"
+#include "random.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+/** Compact target with nZeroBits leading zero bits */
+static uint32_t CompactTargetBits(int nZeroBits)
+{
+    arith_uint256 bnTarget = ~arith_uint256(0) >> nZeroBits;
+    return bnTarget.GetCompact();
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> mapArgs;
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        size_t pos = str.find('=');
+        if (str.size() < 2 || str[0] != '-' || pos == std::string::npos) {
+            std::cerr << "Unexpected argument " << str << std::endl;
+            return 1;
+        }
+        mapArgs[str.substr(1, pos - 1)] = str.substr(pos + 1);
+    }
+    int nChains = std::max(1, mapArgs.count("chains") ? atoi(mapArgs["chains"].c_str()) : 8);
+    int nHashes = std::max(1, mapArgs.count("hashes") ? atoi(mapArgs["hashes"].c_str()) : 20000);
+    int nBits = std::max(0, mapArgs.count("bits") ? atoi(mapArgs["bits"].c_str()) : 4);
+    int nPoWVersion = mapArgs.count("version") ? atoi(mapArgs["version"].c_str()) : LATTICE_POW_VERSION_SINGLE;
+
+    std::cout << "Lattice backend: " << LatticeAutoTune(DEFAULT_LATTICE_TUNE_FILE) << std::endl;
+
+    // Before anything hashes: Hash() and v1/v2 round tables go through this matrix
+    InitializeLatticeMatrix(uint256S(LATTICE_MATRIX_DEFAULT_SEED));
+    uint256 hashPrevBlock = GetRandHash();
+    LatticeRoundTable table;
+    BuildLatticeRoundTable(hashPrevBlock, nPoWVersion, table);
+
+    std::vector<uint64_t> vSolutions(nChains), vVerified(nChains);
+    std::vector<AuxChainWork> vChains(nChains);
+    for (int i = 0; i < nChains; i++) {
+        vChains[i].nChainId = 0x100 + i;
+        vChains[i].hashAuxBlock = GetRandHash();
+        vChains[i].nBits = CompactTargetBits(nBits + i);
+        vChains[i].SolutionFound = [&, i, nPoWVersion](const AuxChainWork& chain, const AuxProof& proof) {
+            vSolutions[i]++;
+            std::string strError;
+            if (CheckAuxProof(proof, chain.nChainId, chain.hashAuxBlock, chain.nBits, nPoWVersion, strError)) {
+                vVerified[i]++;
+            } else {
+                std::cerr << "Chain " << i << ": " << strError << std::endl;
+            }
+        };
+    }
+    CMergedMiningWork work(vChains);
+    if (!work.IsValid()) {
+        std::cerr << "Unable to lay out " << nChains << " aux chains" << std::endl;
+        return 1;
+    }
+
+    // Parent coinbase alone in its block, so its hash is the merkle root
+    std::vector<unsigned char> vCoinbase(42, 0x01);
+    std::vector<unsigned char> vCommitment = work.GetCommitment();
+    vCoinbase.insert(vCoinbase.end(), vCommitment.begin(), vCommitment.end());
+    vCoinbase.insert(vCoinbase.end(), 60, 0x02);
+    uint256 hashMerkleRoot = Hash(vCoinbase.begin(), vCoinbase.end());
+
+    unsigned char header[MERGED_MINING_HEADER_SIZE];
+    WriteLE32(header, 4);
+    memcpy(header + 4, hashPrevBlock.begin(), 32);
+    memcpy(header + 36, hashMerkleRoot.begin(), 32);
+    WriteLE32(header + 68, 1524179366);
+    WriteLE32(header + 72, CompactTargetBits(nBits + nChains));
+
+    std::cout << "=== LATTICE-PoW Merged Mining Benchmark ===" << std::endl;
+    std::cout << "Aux chains: " << nChains << ", tree size: " << ReadLE32(vCommitment.data() + 36)
+              << ", hashes: " << nHashes << ", pow version: " << nPoWVersion << std::endl;
+
+    std::vector<uint256> vPowHashes(nHashes);
+    std::vector<uint256> vNoBranch;
+    int64_t nHashNanos = 0, nCheckNanos = 0;
+    size_t nRouted = 0;
+    for (int nNonce = 0; nNonce < nHashes; nNonce++) {
+        WriteLE32(header + 76, nNonce);
+        int64_t nStart = MetricNanos();
+        vPowHashes[nNonce] = HashLatticePOW(header, header + MERGED_MINING_HEADER_SIZE, table);
+        nHashNanos += MetricNanos() - nStart;
+        nRouted += work.Route(header, vCoinbase, vNoBranch, vPowHashes[nNonce]);
+    }
+
+    // CheckHash alone over the same hashes, the per-hash cost of merging
+    size_t nHits = 0;
+    int64_t nStart = MetricNanos();
+    for (int r = 0; r < 100; r++) {
+        for (const uint256& powHash : vPowHashes) {
+            nHits += work.CheckHash(powHash);
+        }
+    }
+    nCheckNanos = MetricNanos() - nStart;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "HashLatticePOW: " << (double)nHashNanos / nHashes << " ns/hash, CheckHash: "
+              << (double)nCheckNanos / (100.0 * nHashes) << " ns/hash" << std::endl;
+    std::cout << std::setw(8) << "chain" << std::setw(8) << "bits" << std::setw(12) << "expected" << std::setw(12)
+              << "solutions" << std::setw(12) << "verified" << std::endl;
+    uint64_t nFailed = 0;
+    for (int i = 0; i < nChains; i++) {
+        std::cout << std::setw(8) << i << std::setw(8) << nBits + i << std::setw(12) << nHashes / std::pow(2.0, nBits + i)
+                  << std::setw(12) << vSolutions[i] << std::setw(12) << vVerified[i] << std::endl;
+        nFailed += vSolutions[i] - vVerified[i];
+    }
+    std::cout << "Routed: " << nRouted << " solutions from " << nHashes << " parent hashes" << std::endl;
+    return nFailed > 0 || nHits != 100 * nRouted ? 2 : 0;
+}
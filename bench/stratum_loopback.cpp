@@ -0,0 +1,206 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Loopback Stratum benchmark: one CStratumServer and N CStratumLoopbackMiner
+// connections in this process, reporting end-to-end share throughput.
+//
+// Usage: stratum_loopback [miners] [seconds] [validation threads] [metrics port] [-profile]
+//                         [-placement=<policy>] [-governor[=<slo micros>]] [-hashtrace=<path>]
+//                         [-merged=<aux chains>] [-version=<pow version>]
+//
+// With a metrics port, http://127.0.0.1:<port>/metrics is served while the
+// benchmark runs. -profile reports hardware counters per miner nonce batch.
+// -placement pins miner and validation threads: none, core, smt or numa.
+// -governor throttles the miners to keep share validation p99 within the SLO.
+// -hashtrace captures every hash.h call made during the run for tools/hash_replay.
+// -merged commits that many aux chains into the coinbase, chain i needing
+// 2^(i+1) times the share difficulty, and checks every proof routed to them.
+// -version selects the LATTICE-PoW version both the server and miners hash with.
+
+#define GLOBALDEFINED
+#include "hashtrace.h"
+#include "latticemetrics.h"
+#include "latticeplacement.h"
+#include "latticeprofile.h"
+#include "latticetune.h"
+#include "mergedmining.h"
+#include "minergovernor.h"
+#include "stratum.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+
+int main(int argc, char* argv[])
+{
+    bool fProfile = false;
+    bool fGovernor = false;
+    std::string strHashTrace;
+    int nAuxChains = 0;
+    int nPoWVersion = LATTICE_POW_VERSION_SINGLE;
+    GovernorOptions governorOptions;
+    PlacementPolicy placementPolicy = DEFAULT_PLACEMENT_POLICY;
+    std::vector<int> vArgs;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-profile") == 0) {
+            fProfile = true;
+        } else if (strncmp(argv[i], "-governor", 9) == 0) {
+            fGovernor = true;
+            if (argv[i][9] == '=')
+                governorOptions.nLatencySLOMicros = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "-hashtrace=", 11) == 0) {
+            strHashTrace = argv[i] + 11;
+        } else if (strncmp(argv[i], "-merged=", 8) == 0) {
+            nAuxChains = atoi(argv[i] + 8);
+        } else if (strncmp(argv[i], "-version=", 9) == 0) {
+            nPoWVersion = atoi(argv[i] + 9);
+        } else if (strncmp(argv[i], "-placement=", 11) == 0) {
+            if (!ParsePlacementPolicy(argv[i] + 11, placementPolicy)) {
+                std::cerr << "Unknown placement policy " << argv[i] + 11 << std::endl;
+                return 1;
+            }
+        } else {
+            vArgs.push_back(atoi(argv[i]));
+        }
+    }
+    int nMiners = vArgs.size() > 0 ? vArgs[0] : 4;
+    int nSeconds = vArgs.size() > 1 ? vArgs[1] : 10;
+    int nThreads = vArgs.size() > 2 ? vArgs[2] : DEFAULT_STRATUM_THREADS;
+    int nMetricsPort = vArgs.size() > 3 ? vArgs[3] : -1;
+
+    if (fProfile && !EnableLatticeProfile()) {
+        std::cerr << "Hardware counters unavailable; check kernel.perf_event_paranoid" << std::endl;
+        fProfile = false;
+    }
+    SetWorkerPlacement(placementPolicy);
+    // Before the trace starts, so the self-test hashes are not captured
+    std::cout << "Lattice backend: " << LatticeAutoTune(DEFAULT_LATTICE_TUNE_FILE) << std::endl;
+    // Before anything hashes: the template and aux trees below go through this matrix
+    InitializeLatticeMatrix(uint256S(LATTICE_MATRIX_DEFAULT_SEED));
+    if (!strHashTrace.empty() && !StartHashTrace(strHashTrace)) {
+        std::cerr << "Cannot capture to " << strHashTrace << std::endl;
+        return 1;
+    }
+
+    CMetricsServer metrics;
+    if (nMetricsPort >= 0 && !metrics.Start(nMetricsPort)) {
+        std::cerr << "Failed to start metrics server" << std::endl;
+        return 1;
+    }
+
+    // One share per 16 hashes on average so the server side is exercised
+    arith_uint256 shareTarget = UintToArith256(uint256S("0x0fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"));
+
+    StratumTemplate tmpl;
+    tmpl.nVersion = 4;
+    tmpl.hashPrevBlock = uint256S("0x0000000000000000000000000000000000000000000000000000000000000001");
+    tmpl.nTime = 1524179366;
+    tmpl.nBits = 0x1d00ffff;
+    tmpl.coinbasePrefix.assign(42, 0x01);
+    tmpl.coinbaseSuffix.assign(60, 0x02);
+    for (int i = 0; i < 500; i++) {
+        unsigned char n[4] = {(unsigned char)i, (unsigned char)(i >> 8), 0, 0};
+        tmpl.vTxHashes.push_back(Hash(n, n + 4));
+    }
+
+    std::atomic<uint64_t> nAuxSolutions(0), nAuxInvalid(0);
+    if (nAuxChains > 0) {
+        std::vector<AuxChainWork> vChains(nAuxChains);
+        for (int i = 0; i < nAuxChains; i++) {
+            vChains[i].nChainId = 0x100 + i;
+            vChains[i].hashAuxBlock = Hash(&vChains[i].nChainId, &vChains[i].nChainId + 1);
+            vChains[i].nBits = (shareTarget >> (i + 1)).GetCompact();
+            vChains[i].SolutionFound = [&nAuxSolutions, &nAuxInvalid, nPoWVersion](const AuxChainWork& chain, const AuxProof& proof) {
+                std::string strError;
+                if (!CheckAuxProof(proof, chain.nChainId, chain.hashAuxBlock, chain.nBits, nPoWVersion, strError)) {
+                    nAuxInvalid++;
+                    std::cerr << "Aux chain " << chain.nChainId << ": " << strError << std::endl;
+                }
+                nAuxSolutions++;
+            };
+        }
+        std::shared_ptr<CMergedMiningWork> work = std::make_shared<CMergedMiningWork>(vChains);
+        if (!work->IsValid()) {
+            std::cerr << "Unable to lay out " << nAuxChains << " aux chains" << std::endl;
+            return 1;
+        }
+        std::vector<unsigned char> vCommitment = work->GetCommitment();
+        tmpl.coinbasePrefix.insert(tmpl.coinbasePrefix.end(), vCommitment.begin(), vCommitment.end());
+        tmpl.mergedWork = work;
+    }
+
+    CStratumServer server(shareTarget, nThreads, nPoWVersion);
+    if (!server.Start(0)) {
+        std::cerr << "Failed to start stratum server" << std::endl;
+        return 1;
+    }
+    server.NotifyTemplate(tmpl, true);
+
+    CMinerGovernor governor(nMiners, governorOptions);
+    if (fGovernor) {
+        governor.AddQueueDepthSource([&server] { return server.GetValidationQueueDepth(); });
+        governor.SetLatencyHistogram(&g_lattice_metrics.verifyLatency);
+        governor.Start();
+    }
+
+    std::atomic<bool> fStop(false);
+    std::vector<std::unique_ptr<CStratumLoopbackMiner>> vMiners;
+    std::vector<std::thread> vThreads;
+    for (int i = 0; i < nMiners; i++) {
+        vMiners.emplace_back(new CStratumLoopbackMiner(nPoWVersion));
+        if (!vMiners.back()->Connect(server.GetPort())) {
+            std::cerr << "Miner " << i << " failed to connect" << std::endl;
+            return 1;
+        }
+        CStratumLoopbackMiner* miner = vMiners.back().get();
+        if (fGovernor) {
+            miner->governor = &governor;
+            miner->nGovernorWorker = i;
+        }
+        vThreads.emplace_back([miner, &fStop] { miner->Run(fStop); });
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(nSeconds));
+    fStop = true;
+    for (std::thread& thread : vThreads) {
+        thread.join();
+    }
+    // Let in-flight shares finish validating
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+    uint64_t nHashes = 0, nSubmitted = 0;
+    for (const auto& miner : vMiners) {
+        nHashes += miner->nHashes;
+        nSubmitted += miner->nSharesSubmitted;
+    }
+
+    std::cout << "=== LATTICE-PoW Stratum Loopback ===" << std::endl;
+    std::cout << "Miners: " << nMiners << ", validation threads: " << nThreads
+              << ", placement: " << GetPlacementPolicyName(GetWorkerPlacement()) << std::endl;
+    std::cout << "Hash rate: " << std::fixed << std::setprecision(2) << nHashes / elapsed << " H/s" << std::endl;
+    std::cout << "Shares submitted: " << nSubmitted << " (" << nSubmitted / elapsed << "/s)" << std::endl;
+    std::cout << "Shares accepted: " << server.GetSharesAccepted() << " (" << server.GetSharesAccepted() / elapsed << "/s)" << std::endl;
+    std::cout << "Shares rejected: " << server.GetSharesRejected() << std::endl;
+    if (nAuxChains > 0) {
+        std::cout << "Aux solutions: " << nAuxSolutions << " over " << nAuxChains << " chains, "
+                  << nAuxInvalid << " failed verification" << std::endl;
+    }
+    if (fGovernor) {
+        std::cout << "Governor: " << governor.GetActiveWorkers() << " of " << nMiners << " miners active at "
+                  << governor.GetDutyCycle() * 100 << "% duty" << std::endl;
+    }
+    if (fProfile) {
+        std::cout << std::endl << "Per-nonce hardware counters:" << std::endl;
+        std::cout << FormatLatticeProfile();
+    }
+
+    server.Stop();
+    if (!strHashTrace.empty()) {
+        StopHashTrace();
+        std::cout << "Hash trace: " << GetHashTraceBytes() << " bytes in " << strHashTrace << std::endl;
+    }
+    return 0;
+}
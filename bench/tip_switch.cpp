@@ -0,0 +1,128 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Tip switch latency with and without CLatticePrecomputer.
+//
+// Usage: tip_switch [-races=<n>] [-candidates=<n>] [-gap=<millis>] [-version=<pow version>]
+//
+// Each race announces -candidates random tips, waits -gap milliseconds (the
+// time between seeing a competing header and learning which block won),
+// then switches to one of them and hashes the first four nonces on it,
+// resuming from the midstate of the prefix announced with the tip. The same
+// switch is timed against a cold BuildLatticeRoundTable and prefix
+// permutation on a tip nobody announced.
+
+#define GLOBALDEFINED
+#include "latticemetrics.h"
+#include "latticeprecompute.h"
+#include "latticetune.h"
+#include "crypto/sha3.h"
+#include "random.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+
+static void PrintLatency(const std::string& strName, std::vector<int64_t>& vNanos)
+{
+    std::sort(vNanos.begin(), vNanos.end());
+    int64_t nSum = 0;
+    for (int64_t n : vNanos) {
+        nSum += n;
+    }
+    std::cout << std::left << std::setw(14) << strName << std::right
+              << " avg " << std::setw(10) << nSum / 1000.0 / vNanos.size() << " us"
+              << "  p50 " << std::setw(10) << vNanos[vNanos.size() / 2] / 1000.0 << " us"
+              << "  max " << std::setw(10) << vNanos.back() / 1000.0 << " us" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> mapArgs;
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        size_t pos = str.find('=');
+        if (str.size() < 2 || str[0] != '-' || pos == std::string::npos) {
+            std::cerr << "Unexpected argument " << str << std::endl;
+            return 1;
+        }
+        mapArgs[str.substr(1, pos - 1)] = str.substr(pos + 1);
+    }
+    int nRaces = std::max(1, mapArgs.count("races") ? atoi(mapArgs["races"].c_str()) : 20);
+    int nCandidates = std::max(1, mapArgs.count("candidates") ? atoi(mapArgs["candidates"].c_str()) : 2);
+    int nGapMillis = std::max(0, mapArgs.count("gap") ? atoi(mapArgs["gap"].c_str()) : 50);
+    int nPoWVersion = mapArgs.count("version") ? atoi(mapArgs["version"].c_str()) : LATTICE_POW_VERSION_XOF;
+
+    std::cout << "=== LATTICE-PoW Tip Switch Benchmark ===" << std::endl;
+    std::cout << "Races: " << nRaces << ", candidates: " << nCandidates << ", gap: " << nGapMillis
+              << " ms, pow version: " << nPoWVersion << std::endl;
+    std::cout << "Lattice backend: " << LatticeAutoTune(DEFAULT_LATTICE_TUNE_FILE) << std::endl;
+
+    CLatticePrecomputer precomputer(std::max<size_t>(nCandidates, DEFAULT_PRECOMPUTE_TIPS));
+    precomputer.Start();
+
+    std::vector<int64_t> vCold, vPrecomputed;
+    unsigned char header[4][80];
+    const unsigned char* headers[4] = {header[0], header[1], header[2], header[3]};
+    uint256 powHash[4];
+    uint64_t nMidstates = 0;
+    for (int race = 0; race < nRaces; race++) {
+        GetRandBytes(header[0], sizeof(header[0]));
+        for (int k = 1; k < 4; k++) {
+            memcpy(header[k], header[0], 76);
+            WriteLE32(header[k] + 76, k);
+        }
+
+        LatticeRoundTable table;
+        uint64_t prefix[25];
+        const uint64_t* prefixes[4] = {prefix, prefix, prefix, prefix};
+        int64_t nStart = MetricNanos();
+        BuildLatticeRoundTable(GetRandHash(), nPoWVersion, table);
+        Keccak512_80Prefix(header[0], prefix);
+        HashLatticePOW4(headers, prefixes, table, powHash);
+        vCold.push_back(MetricNanos() - nStart);
+
+        // Each candidate comes with the prefix we would mine on it
+        std::vector<uint256> vTips;
+        std::vector<std::vector<unsigned char>> vPrefixes;
+        for (int i = 0; i < nCandidates; i++) {
+            vTips.push_back(GetRandHash());
+            vPrefixes.emplace_back(LATTICE_HEADER_PREFIX_SIZE);
+            GetRandBytes(vPrefixes.back().data(), LATTICE_HEADER_PREFIX_SIZE);
+            precomputer.AddCandidate(vTips.back(), nPoWVersion, vPrefixes.back().data());
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(nGapMillis));
+
+        int nWinner = GetRand(nCandidates);
+        for (int k = 0; k < 4; k++) {
+            memcpy(header[k], vPrefixes[nWinner].data(), LATTICE_HEADER_PREFIX_SIZE);
+        }
+        LatticeTipState tip;
+        nStart = MetricNanos();
+        precomputer.GetTip(vTips[nWinner], nPoWVersion, tip);
+        const uint64_t* midstate = tip.GetMidstate(header[0]);
+        if (midstate) {
+            nMidstates++;
+        } else {
+            Keccak512_80Prefix(header[0], prefix);
+            midstate = prefix;
+        }
+        const uint64_t* midstates[4] = {midstate, midstate, midstate, midstate};
+        HashLatticePOW4(headers, midstates, tip.table, powHash);
+        vPrecomputed.push_back(MetricNanos() - nStart);
+    }
+    precomputer.Stop();
+
+    std::cout << std::fixed << std::setprecision(1);
+    PrintLatency("cold", vCold);
+    PrintLatency("precomputed", vPrecomputed);
+    std::cout << "Hits: " << precomputer.GetHits() << ", waited: " << precomputer.GetWaits()
+              << ", built on demand: " << precomputer.GetMisses() << ", midstates used: " << nMidstates << std::endl;
+    return 0;
+}
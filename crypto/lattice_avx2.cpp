@@ -0,0 +1,44 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// AVX2 8x8 lattice matrix-vector product. Compiled with -mavx2 and selected at
+// runtime by LatticeAutoTune.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace lattice_avx2 {
+
+/**
+ * sums[i] = sum_j vector[j] * matrix[i][j] for an 8x8 row-major matrix,
+ * without modular reduction. Inputs must be below 2^12 so every sum fits in
+ * 32 bits.
+ */
+void MatrixMultiply8(const uint32_t* vector, const uint32_t* matrix, uint32_t* sums)
+{
+    const __m256i v = _mm256_loadu_si256((const __m256i*)vector);
+    __m256i p[8];
+    for (int i = 0; i < 8; i++) {
+        p[i] = _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i*)(matrix + 8 * i)), v);
+    }
+
+    // Horizontal add tree: low lane holds partial sums of elements 0..3,
+    // high lane of elements 4..7, for rows 0..3 and 4..7 respectively
+    __m256i h01 = _mm256_hadd_epi32(p[0], p[1]);
+    __m256i h23 = _mm256_hadd_epi32(p[2], p[3]);
+    __m256i h45 = _mm256_hadd_epi32(p[4], p[5]);
+    __m256i h67 = _mm256_hadd_epi32(p[6], p[7]);
+    __m256i h0123 = _mm256_hadd_epi32(h01, h23);
+    __m256i h4567 = _mm256_hadd_epi32(h45, h67);
+
+    __m256i lo = _mm256_permute2x128_si256(h0123, h4567, 0x20);
+    __m256i hi = _mm256_permute2x128_si256(h0123, h4567, 0x31);
+    _mm256_storeu_si256((__m256i*)sums, _mm256_add_epi32(lo, hi));
+}
+
+} // namespace lattice_avx2
+
+#endif
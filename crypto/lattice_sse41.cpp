@@ -0,0 +1,39 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// SSE4.1 8x8 lattice matrix-vector product. Compiled with -msse4.1 and
+// selected at runtime by LatticeAutoTune.
+
+#ifdef ENABLE_SSE41
+
+#include <stdint.h>
+#include <immintrin.h>
+
+namespace lattice_sse41 {
+
+/**
+ * sums[i] = sum_j vector[j] * matrix[i][j] for an 8x8 row-major matrix,
+ * without modular reduction. Inputs must be below 2^12 so every sum fits in
+ * 32 bits.
+ */
+void MatrixMultiply8(const uint32_t* vector, const uint32_t* matrix, uint32_t* sums)
+{
+    const __m128i vlo = _mm_loadu_si128((const __m128i*)vector);
+    const __m128i vhi = _mm_loadu_si128((const __m128i*)(vector + 4));
+    __m128i p[8];
+    for (int i = 0; i < 8; i++) {
+        const uint32_t* row = matrix + 8 * i;
+        p[i] = _mm_add_epi32(_mm_mullo_epi32(_mm_loadu_si128((const __m128i*)row), vlo),
+                             _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)(row + 4)), vhi));
+    }
+
+    __m128i s0123 = _mm_hadd_epi32(_mm_hadd_epi32(p[0], p[1]), _mm_hadd_epi32(p[2], p[3]));
+    __m128i s4567 = _mm_hadd_epi32(_mm_hadd_epi32(p[4], p[5]), _mm_hadd_epi32(p[6], p[7]));
+    _mm_storeu_si128((__m128i*)sums, s0123);
+    _mm_storeu_si128((__m128i*)(sums + 4), s4567);
+}
+
+} // namespace lattice_sse41
+
+#endif
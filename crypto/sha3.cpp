@@ -0,0 +1,255 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/sha3.h"
+
+#include "crypto/common.h"
+
+#include <string.h>
+
+namespace {
+
+const uint64_t RNDC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+#if defined(__GNUC__)
+/** Four 64-bit lanes operated on together; becomes SIMD where the target has it */
+typedef uint64_t Lane4 __attribute__((vector_size(32)));
+#endif
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+/** Keccak-f[1600] over one state of lane type T, fully unrolled */
+template<typename T>
+inline void KeccakFRounds(T (&st)[25])
+{
+    T c0, c1, c2, c3, c4, d0, d1, d2, d3, d4;
+    T b00, b01, b02, b03, b04, b05, b06, b07, b08, b09, b10, b11, b12, b13, b14, b15, b16, b17, b18, b19, b20, b21, b22, b23, b24;
+    for (int round = 0; round < 24; round++) {
+        // Theta
+        c0 = st[0] ^ st[5] ^ st[10] ^ st[15] ^ st[20];
+        c1 = st[1] ^ st[6] ^ st[11] ^ st[16] ^ st[21];
+        c2 = st[2] ^ st[7] ^ st[12] ^ st[17] ^ st[22];
+        c3 = st[3] ^ st[8] ^ st[13] ^ st[18] ^ st[23];
+        c4 = st[4] ^ st[9] ^ st[14] ^ st[19] ^ st[24];
+        d0 = c4 ^ ROTL(c1, 1);
+        d1 = c0 ^ ROTL(c2, 1);
+        d2 = c1 ^ ROTL(c3, 1);
+        d3 = c2 ^ ROTL(c4, 1);
+        d4 = c3 ^ ROTL(c0, 1);
+
+        // Theta applied, then rho and pi: b[y + 5*((2x + 3y) % 5)] = rotl(a[x + 5y])
+        b00 = (st[0] ^ d0);
+        b10 = ROTL((st[1] ^ d1), 1);
+        b20 = ROTL((st[2] ^ d2), 62);
+        b05 = ROTL((st[3] ^ d3), 28);
+        b15 = ROTL((st[4] ^ d4), 27);
+        b16 = ROTL((st[5] ^ d0), 36);
+        b01 = ROTL((st[6] ^ d1), 44);
+        b11 = ROTL((st[7] ^ d2), 6);
+        b21 = ROTL((st[8] ^ d3), 55);
+        b06 = ROTL((st[9] ^ d4), 20);
+        b07 = ROTL((st[10] ^ d0), 3);
+        b17 = ROTL((st[11] ^ d1), 10);
+        b02 = ROTL((st[12] ^ d2), 43);
+        b12 = ROTL((st[13] ^ d3), 25);
+        b22 = ROTL((st[14] ^ d4), 39);
+        b23 = ROTL((st[15] ^ d0), 41);
+        b08 = ROTL((st[16] ^ d1), 45);
+        b18 = ROTL((st[17] ^ d2), 15);
+        b03 = ROTL((st[18] ^ d3), 21);
+        b13 = ROTL((st[19] ^ d4), 8);
+        b14 = ROTL((st[20] ^ d0), 18);
+        b24 = ROTL((st[21] ^ d1), 2);
+        b09 = ROTL((st[22] ^ d2), 61);
+        b19 = ROTL((st[23] ^ d3), 56);
+        b04 = ROTL((st[24] ^ d4), 14);
+
+        // Chi
+        st[0] = b00 ^ (~b01 & b02);
+        st[1] = b01 ^ (~b02 & b03);
+        st[2] = b02 ^ (~b03 & b04);
+        st[3] = b03 ^ (~b04 & b00);
+        st[4] = b04 ^ (~b00 & b01);
+        st[5] = b05 ^ (~b06 & b07);
+        st[6] = b06 ^ (~b07 & b08);
+        st[7] = b07 ^ (~b08 & b09);
+        st[8] = b08 ^ (~b09 & b05);
+        st[9] = b09 ^ (~b05 & b06);
+        st[10] = b10 ^ (~b11 & b12);
+        st[11] = b11 ^ (~b12 & b13);
+        st[12] = b12 ^ (~b13 & b14);
+        st[13] = b13 ^ (~b14 & b10);
+        st[14] = b14 ^ (~b10 & b11);
+        st[15] = b15 ^ (~b16 & b17);
+        st[16] = b16 ^ (~b17 & b18);
+        st[17] = b17 ^ (~b18 & b19);
+        st[18] = b18 ^ (~b19 & b15);
+        st[19] = b19 ^ (~b15 & b16);
+        st[20] = b20 ^ (~b21 & b22);
+        st[21] = b21 ^ (~b22 & b23);
+        st[22] = b22 ^ (~b23 & b24);
+        st[23] = b23 ^ (~b24 & b20);
+        st[24] = b24 ^ (~b20 & b21);
+
+        // Iota
+        st[0] ^= RNDC[round];
+    }
+}
+
+#undef ROTL
+
+} // namespace
+
+void KeccakF(uint64_t (&st)[25])
+{
+    KeccakFRounds(st);
+}
+
+void KeccakF4(uint64_t (&st)[25][4])
+{
+#if defined(__GNUC__)
+    Lane4 lanes[25];
+    memcpy(lanes, st, sizeof(lanes));
+    KeccakFRounds(lanes);
+    memcpy(st, lanes, sizeof(lanes));
+#else
+    for (int k = 0; k < 4; k++) {
+        uint64_t lanes[25];
+        for (int i = 0; i < 25; i++)
+            lanes[i] = st[i][k];
+        KeccakFRounds(lanes);
+        for (int i = 0; i < 25; i++)
+            st[i][k] = lanes[i];
+    }
+#endif
+}
+
+/** Keccak-512 absorbs 72 bytes (9 lanes) per permutation */
+static const int KECCAK512_RATE_LANES = 9;
+
+static inline void Keccak512Squeeze(const uint64_t (&st)[25], unsigned char out[64])
+{
+    for (int i = 0; i < 8; i++)
+        WriteLE64(out + 8 * i, st[i]);
+}
+
+void Keccak512_32(const unsigned char in[32], unsigned char out[64])
+{
+    uint64_t st[25] = {};
+    for (int i = 0; i < 4; i++)
+        st[i] = ReadLE64(in + 8 * i);
+    // Keccak pad10*1: 0x01 after the message, 0x80 in the last rate byte
+    st[4] = 0x01;
+    st[KECCAK512_RATE_LANES - 1] = 0x8000000000000000ULL;
+    KeccakFRounds(st);
+    Keccak512Squeeze(st, out);
+}
+
+void Keccak512_80(const unsigned char in[80], unsigned char out[64])
+{
+    uint64_t st[25] = {};
+    for (int i = 0; i < KECCAK512_RATE_LANES; i++)
+        st[i] = ReadLE64(in + 8 * i);
+    KeccakFRounds(st);
+    st[0] ^= ReadLE64(in + 72);
+    st[1] ^= 0x01;
+    st[KECCAK512_RATE_LANES - 1] ^= 0x8000000000000000ULL;
+    KeccakFRounds(st);
+    Keccak512Squeeze(st, out);
+}
+
+void Keccak512_80Prefix(const unsigned char in[72], uint64_t (&st)[25])
+{
+    memset(st, 0, sizeof(st));
+    for (int i = 0; i < KECCAK512_RATE_LANES; i++)
+        st[i] = ReadLE64(in + 8 * i);
+    KeccakFRounds(st);
+}
+
+static inline void Keccak512Squeeze4(const uint64_t (&st)[25][4], unsigned char out[4][64])
+{
+    for (int k = 0; k < 4; k++) {
+        for (int i = 0; i < 8; i++)
+            WriteLE64(out[k] + 8 * i, st[i][k]);
+    }
+}
+
+void Keccak512_80x4(const uint64_t* const prefix[4], const unsigned char* const tail[4], unsigned char out[4][64])
+{
+    uint64_t st[25][4];
+    for (int k = 0; k < 4; k++) {
+        for (int i = 0; i < 25; i++)
+            st[i][k] = prefix[k][i];
+        st[0][k] ^= ReadLE64(tail[k]);
+        st[1][k] ^= 0x01;
+        st[KECCAK512_RATE_LANES - 1][k] ^= 0x8000000000000000ULL;
+    }
+    KeccakF4(st);
+    Keccak512Squeeze4(st, out);
+}
+
+void Keccak512_32x4(const unsigned char* const in[4], unsigned char out[4][64])
+{
+    uint64_t st[25][4] = {};
+    for (int k = 0; k < 4; k++) {
+        for (int i = 0; i < 4; i++)
+            st[i][k] = ReadLE64(in[k] + 8 * i);
+        st[4][k] = 0x01;
+        st[KECCAK512_RATE_LANES - 1][k] = 0x8000000000000000ULL;
+    }
+    KeccakF4(st);
+    Keccak512Squeeze4(st, out);
+}
+
+CSHAKE128::CSHAKE128()
+{
+    Reset();
+}
+
+CSHAKE128& CSHAKE128::Reset()
+{
+    memset(state, 0, sizeof(state));
+    nPos = 0;
+    fSqueezing = false;
+    return *this;
+}
+
+CSHAKE128& CSHAKE128::Write(const unsigned char* data, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        state[nPos / 8] ^= (uint64_t)data[i] << (8 * (nPos % 8));
+        if (++nPos == RATE) {
+            KeccakF(state);
+            nPos = 0;
+        }
+    }
+    return *this;
+}
+
+void CSHAKE128::Squeeze(unsigned char* out, size_t len)
+{
+    if (!fSqueezing) {
+        // SHAKE domain separation and pad10*1
+        state[nPos / 8] ^= (uint64_t)0x1F << (8 * (nPos % 8));
+        state[(RATE - 1) / 8] ^= (uint64_t)0x80 << (8 * ((RATE - 1) % 8));
+        KeccakF(state);
+        nPos = 0;
+        fSqueezing = true;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (nPos == RATE) {
+            KeccakF(state);
+            nPos = 0;
+        }
+        out[i] = state[nPos / 8] >> (8 * (nPos % 8));
+        nPos++;
+    }
+}
@@ -0,0 +1,61 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_CRYPTO_SHA3_H
+#define LATTICE_CRYPTO_SHA3_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Keccak-f[1600] on one state of 25 little-endian lanes */
+void KeccakF(uint64_t (&st)[25]);
+
+/**
+ * Keccak-f[1600] on four independent states, lane-interleaved so that
+ * st[i][k] is lane i of state k. Each step runs over the four states
+ * together, which the compiler turns into SIMD where available.
+ */
+void KeccakF4(uint64_t (&st)[25][4]);
+
+/**
+ * One-shot Keccak-512 with the original Keccak padding, bit-identical to
+ * sph_keccak512, for inputs of exactly 32 and 80 bytes. The input goes
+ * straight into the lanes and is padded, permuted and squeezed without a
+ * buffering context.
+ */
+void Keccak512_32(const unsigned char in[32], unsigned char out[64]);
+void Keccak512_80(const unsigned char in[80], unsigned char out[64]);
+
+/** Keccak-512 state after absorbing the first 72-byte block of an 80-byte input */
+void Keccak512_80Prefix(const unsigned char in[72], uint64_t (&st)[25]);
+
+/**
+ * Four Keccak512_80 through KeccakF4, each resumed from the
+ * Keccak512_80Prefix state of its first 72 bytes; tail[k] is its last 8.
+ * Inputs sharing a prefix share one prefix permutation.
+ */
+void Keccak512_80x4(const uint64_t* const prefix[4], const unsigned char* const tail[4], unsigned char out[4][64]);
+
+/** Four Keccak512_32 through KeccakF4 */
+void Keccak512_32x4(const unsigned char* const in[4], unsigned char out[4][64]);
+
+/** SHAKE128 extendable-output function (FIPS 202) */
+class CSHAKE128
+{
+public:
+    static const size_t RATE = 168;
+
+    CSHAKE128();
+    CSHAKE128& Write(const unsigned char* data, size_t len);
+    /** Produce output; the first call finishes absorbing, so Write must not follow */
+    void Squeeze(unsigned char* out, size_t len);
+    CSHAKE128& Reset();
+
+private:
+    uint64_t state[25];
+    size_t nPos;
+    bool fSqueezing;
+};
+
+#endif // LATTICE_CRYPTO_SHA3_H
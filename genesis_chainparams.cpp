@@ -1,6 +1,10 @@
 // LATTICE-PoW Genesis Block Generation Code
 // Place this code in chainparams.cpp for genesis mining
 //
+// For long searches at a tight target use tools/genesis_search instead: it
+// spreads the nonce space over threads and checkpoints progress so an
+// interrupted search resumes where it stopped.
+//
 //        arith_uint256 test;
 //        bool fNegative;
 //        bool fOverflow;
@@ -0,0 +1,205 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "genesissearch.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+
+bool GenesisSearchParams::operator==(const GenesisSearchParams& other) const
+{
+    return nVersion == other.nVersion && hashPrevBlock == other.hashPrevBlock && hashMerkleRoot == other.hashMerkleRoot &&
+           nTime == other.nTime && nBits == other.nBits && nPoWVersion == other.nPoWVersion && matrixSeed == other.matrixSeed;
+}
+
+uint64_t GenesisCheckpoint::GetSearched() const
+{
+    uint64_t nSearched = 0;
+    for (const GenesisRange& range : vRanges) {
+        nSearched += range.nNext - range.nBegin;
+    }
+    return nSearched;
+}
+
+uint64_t GenesisCheckpoint::GetRemaining() const
+{
+    uint64_t nRemaining = 0;
+    for (const GenesisRange& range : vRanges) {
+        nRemaining += range.nEnd - range.nNext;
+    }
+    return nRemaining;
+}
+
+std::vector<GenesisRange> SplitGenesisRange(uint64_t nStart, uint64_t nEnd, int nWorkers)
+{
+    std::vector<GenesisRange> vRanges;
+    nWorkers = std::max(nWorkers, 1);
+    uint64_t nSize = nEnd > nStart ? nEnd - nStart : 0;
+    for (int i = 0; i < nWorkers; i++) {
+        GenesisRange range;
+        range.nBegin = nStart + nSize * i / nWorkers;
+        range.nNext = range.nBegin;
+        range.nEnd = nStart + nSize * (i + 1) / nWorkers;
+        vRanges.push_back(range);
+    }
+    return vRanges;
+}
+
+void BuildGenesisHeader(const GenesisSearchParams& params, uint32_t nNonce, unsigned char header[BLOCK_HEADER_SIZE])
+{
+    WriteLE32(header, (uint32_t)params.nVersion);
+    memcpy(header + 4, params.hashPrevBlock.begin(), 32);
+    memcpy(header + 36, params.hashMerkleRoot.begin(), 32);
+    WriteLE32(header + 68, params.nTime);
+    WriteLE32(header + 72, params.nBits);
+    WriteLE32(header + 76, nNonce);
+}
+
+static std::string GetChecksum(const std::string& strBody)
+{
+    uint64_t nHash = CSipHasher(0, 0).Write((const unsigned char*)strBody.data(), strBody.size()).Finalize();
+    return strprintf("%016x", nHash);
+}
+
+bool WriteGenesisCheckpoint(const std::string& strPath, const GenesisCheckpoint& checkpoint)
+{
+    const GenesisSearchParams& params = checkpoint.params;
+    std::string strBody = "# LATTICE-PoW genesis search checkpoint\n";
+    strBody += strprintf("format=%d\n", GENESIS_CHECKPOINT_VERSION);
+    strBody += strprintf("version=%d\n", params.nVersion);
+    strBody += strprintf("prev=%s\n", params.hashPrevBlock.GetHex());
+    strBody += strprintf("merkle=%s\n", params.hashMerkleRoot.GetHex());
+    strBody += strprintf("time=%u\n", params.nTime);
+    strBody += strprintf("bits=%08x\n", params.nBits);
+    strBody += strprintf("powversion=%d\n", params.nPoWVersion);
+    strBody += strprintf("matrixseed=%s\n", params.matrixSeed.GetHex());
+    for (const GenesisRange& range : checkpoint.vRanges) {
+        strBody += strprintf("range=%u,%u,%u\n", range.nBegin, range.nNext, range.nEnd);
+    }
+    if (checkpoint.fBest)
+        strBody += strprintf("best=%s,%u\n", checkpoint.bestHash.GetHex(), checkpoint.nBestNonce);
+    if (checkpoint.fFound)
+        strBody += strprintf("found=%u\n", checkpoint.nFoundNonce);
+    strBody += strprintf("elapsed_ms=%d\n", checkpoint.nElapsedMillis);
+    std::string strData = strBody + "checksum=" + GetChecksum(strBody) + "\n";
+
+    std::string strTemp = strPath + ".new";
+    FILE* file = fopen(strTemp.c_str(), "wb");
+    if (file == nullptr) {
+        LogPrintf("Genesis search: unable to write %s\n", strTemp);
+        return false;
+    }
+    bool fOk = fwrite(strData.data(), 1, strData.size(), file) == strData.size() && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    fOk = fclose(file) == 0 && fOk;
+    if (!fOk || rename(strTemp.c_str(), strPath.c_str()) != 0) {
+        LogPrintf("Genesis search: unable to write checkpoint %s\n", strPath);
+        remove(strTemp.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool ParseUInt64(const std::string& str, uint64_t& n)
+{
+    if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    n = strtoull(str.c_str(), nullptr, 10);
+    return true;
+}
+
+bool ReadGenesisCheckpoint(const std::string& strPath, GenesisCheckpoint& checkpoint, std::string& strError)
+{
+    std::ifstream file(strPath);
+    if (!file.is_open()) {
+        strError = "cannot open " + strPath;
+        return false;
+    }
+
+    checkpoint = GenesisCheckpoint();
+    GenesisSearchParams& params = checkpoint.params;
+    std::string line, strBody, strChecksum, strFormat;
+    int nParams = 0;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 9, "checksum=") == 0) {
+            strChecksum = line.substr(9);
+            break;
+        }
+        strBody += line + "\n";
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t pos = line.find('=');
+        if (pos == std::string::npos)
+            continue;
+        std::string key = line.substr(0, pos), value = line.substr(pos + 1);
+        if (key == "format") {
+            strFormat = value;
+        } else if (key == "version") {
+            params.nVersion = atoi(value.c_str());
+            nParams++;
+        } else if (key == "prev") {
+            params.hashPrevBlock = uint256S(value);
+            nParams++;
+        } else if (key == "merkle") {
+            params.hashMerkleRoot = uint256S(value);
+            nParams++;
+        } else if (key == "time") {
+            params.nTime = strtoul(value.c_str(), nullptr, 10);
+            nParams++;
+        } else if (key == "bits") {
+            params.nBits = strtoul(value.c_str(), nullptr, 16);
+            nParams++;
+        } else if (key == "powversion") {
+            params.nPoWVersion = atoi(value.c_str());
+            nParams++;
+        } else if (key == "matrixseed") {
+            params.matrixSeed = uint256S(value);
+            nParams++;
+        } else if (key == "range") {
+            size_t p1 = value.find(','), p2 = value.find(',', p1 + 1);
+            GenesisRange range;
+            if (p1 == std::string::npos || p2 == std::string::npos || !ParseUInt64(value.substr(0, p1), range.nBegin) ||
+                !ParseUInt64(value.substr(p1 + 1, p2 - p1 - 1), range.nNext) || !ParseUInt64(value.substr(p2 + 1), range.nEnd) ||
+                range.nBegin > range.nNext || range.nNext > range.nEnd || range.nEnd > GENESIS_NONCE_LIMIT) {
+                strError = "bad range " + value;
+                return false;
+            }
+            checkpoint.vRanges.push_back(range);
+        } else if (key == "best") {
+            size_t p = value.find(',');
+            uint64_t nNonce;
+            if (p == std::string::npos || !ParseUInt64(value.substr(p + 1), nNonce)) {
+                strError = "bad best " + value;
+                return false;
+            }
+            checkpoint.fBest = true;
+            checkpoint.bestHash = uint256S(value.substr(0, p));
+            checkpoint.nBestNonce = nNonce;
+        } else if (key == "found") {
+            checkpoint.fFound = true;
+            checkpoint.nFoundNonce = strtoul(value.c_str(), nullptr, 10);
+        } else if (key == "elapsed_ms") {
+            checkpoint.nElapsedMillis = strtoll(value.c_str(), nullptr, 10);
+        }
+    }
+
+    if (strChecksum != GetChecksum(strBody)) {
+        strError = "checksum mismatch, file is damaged";
+        return false;
+    }
+    if (strFormat != std::to_string(GENESIS_CHECKPOINT_VERSION)) {
+        strError = "unsupported format " + strFormat;
+        return false;
+    }
+    if (nParams != 7 || checkpoint.vRanges.empty()) {
+        strError = "missing search parameters";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_GENESISSEARCH_H
+#define LATTICE_GENESISSEARCH_H
+
+#include "hash.h"
+
+#include <string>
+#include <vector>
+
+static const int GENESIS_CHECKPOINT_VERSION = 2;
+static const char* const DEFAULT_GENESIS_CHECKPOINT = "genesis.checkpoint";
+static const int64_t DEFAULT_GENESIS_CHECKPOINT_SECONDS = 60;
+/** Nonces a worker hashes between progress updates */
+static const uint32_t GENESIS_BATCH_SIZE = 4096;
+static const uint64_t GENESIS_NONCE_LIMIT = (uint64_t)1 << 32;
+
+/** Everything that determines the hashes being searched */
+struct GenesisSearchParams {
+    int32_t nVersion;
+    uint256 hashPrevBlock;
+    uint256 hashMerkleRoot;
+    uint32_t nTime;
+    uint32_t nBits;
+    int nPoWVersion;
+    uint256 matrixSeed;         // InitializeLatticeMatrix seed, for the v1/v2 matrix
+
+    bool operator==(const GenesisSearchParams& other) const;
+    bool operator!=(const GenesisSearchParams& other) const { return !(*this == other); }
+};
+
+/** One worker's share of the nonce space: [nBegin, nNext) is done, [nNext, nEnd) is left */
+struct GenesisRange {
+    uint64_t nBegin;
+    uint64_t nNext;
+    uint64_t nEnd;
+};
+
+struct GenesisCheckpoint {
+    GenesisSearchParams params;
+    std::vector<GenesisRange> vRanges;
+    bool fBest;
+    uint256 bestHash;
+    uint32_t nBestNonce;
+    bool fFound;
+    uint32_t nFoundNonce;
+    int64_t nElapsedMillis;     // Search time over all runs
+
+    GenesisCheckpoint() : fBest(false), nBestNonce(0), fFound(false), nFoundNonce(0), nElapsedMillis(0) {}
+
+    uint64_t GetSearched() const;
+    uint64_t GetRemaining() const;
+};
+
+/** Split [nStart, nEnd) into nWorkers contiguous ranges */
+std::vector<GenesisRange> SplitGenesisRange(uint64_t nStart, uint64_t nEnd, int nWorkers);
+
+/** Serialized 80-byte header for one nonce */
+void BuildGenesisHeader(const GenesisSearchParams& params, uint32_t nNonce, unsigned char header[BLOCK_HEADER_SIZE]);
+
+/**
+ * Checkpoints are small key=value text files ending in a SipHash checksum.
+ * They are written to a temporary file, synced and renamed over the old
+ * one, so a crash mid-write leaves the previous checkpoint intact.
+ */
+bool WriteGenesisCheckpoint(const std::string& strPath, const GenesisCheckpoint& checkpoint);
+bool ReadGenesisCheckpoint(const std::string& strPath, GenesisCheckpoint& checkpoint, std::string& strError);
+
+#endif // LATTICE_GENESISSEARCH_H
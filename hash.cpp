@@ -6,13 +6,19 @@
 #include "hash.h"
 #include "crypto/common.h"
 #include "crypto/hmac_sha512.h"
+#include "crypto/sha3.h"
+#include "latticemetrics.h"
+#include "latticestore.h"
 #include "pubkey.h"
 #include <cstring>
 #include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 // LATTICE-PoW global variables
-double latticeOpTotal[LATTICE_ROUNDS];
-int latticeOpHits[LATTICE_ROUNDS];
+thread_local double latticeOpTotal[LATTICE_ROUNDS];
+thread_local int latticeOpHits[LATTICE_ROUNDS];
 
 /**
  * Modular reduction for lattice operations
@@ -31,7 +37,14 @@ uint32_t ModularReduce(int64_t value) {
  * Creates deterministic but pseudorandom lattice structure
  */
 void InitializeLatticeMatrix(const uint256& seed) {
-    if (lattice_initialized) return;
+    // Legacy HashLatticePOW gets here once per hash, so only the expansion is counted
+    if (lattice_initialized.load(std::memory_order_acquire))
+        return;
+    static std::mutex cs_init;
+    std::lock_guard<std::mutex> lock(cs_init);
+    if (lattice_initialized.load(std::memory_order_relaxed))
+        return;
+    g_lattice_metrics.matrixCacheMisses.Add();
     
     sph_keccac512_context ctx;
     uint8_t expanded_seed[64];
@@ -68,22 +81,124 @@ void InitializeLatticeMatrix(const uint256& seed) {
         }
     }
     
-    lattice_initialized = true;
+    lattice_matrix_seed = seed;
+    lattice_initialized.store(true, std::memory_order_release);
 }
 
 /**
- * Generate error vector for Ring Learning With Errors
- * Creates small random errors for cryptographic hardness
+ * Expand rows [nFirst, nFirst + 4) of an XOF matrix, one SHAKE128 stream
+ * per row, all four through KeccakF4. Rows past nRows are computed and dropped.
  */
-void GenerateErrorVector(const uint256& seed, std::array<uint32_t, LATTICE_DIMENSION>& error) {
-    sph_keccac512_context ctx;
-    uint8_t error_seed[64];
-    
-    // Expand error seed
-    sph_keccac512_init(&ctx);
-    sph_keccac512(&ctx, seed.begin(), 32);
-    sph_keccac512_close(&ctx, error_seed);
-    
+static void ExpandLatticeRowsXOF(const uint256& seed, uint32_t nFirst, uint32_t nRows, uint32_t nCols, uint32_t* matrix)
+{
+    static const size_t RATE = CSHAKE128::RATE;
+    uint64_t st[25][4] = {};
+
+    // seed || LE16(row) || LE16(nCols) fits in one block
+    unsigned char input[36];
+    memcpy(input, seed.begin(), 32);
+    input[34] = nCols & 0xFF;
+    input[35] = nCols >> 8;
+    for (int k = 0; k < 4; k++) {
+        input[32] = (nFirst + k) & 0xFF;
+        input[33] = (nFirst + k) >> 8;
+        for (size_t p = 0; p < sizeof(input); p++) {
+            st[p / 8][k] ^= (uint64_t)input[p] << (8 * (p % 8));
+        }
+        st[sizeof(input) / 8][k] ^= (uint64_t)0x1F << (8 * (sizeof(input) % 8));
+        st[(RATE - 1) / 8][k] ^= (uint64_t)0x80 << (8 * ((RATE - 1) % 8));
+    }
+
+    uint32_t nFilled[4] = {};
+    unsigned char block[RATE];
+    bool fDone = false;
+    while (!fDone) {
+        KeccakF4(st);
+        fDone = true;
+        for (int k = 0; k < 4; k++) {
+            uint32_t nRow = nFirst + k;
+            if (nRow >= nRows || nFilled[k] == nCols)
+                continue;
+            for (size_t p = 0; p < RATE; p++) {
+                block[p] = st[p / 8][k] >> (8 * (p % 8));
+            }
+            uint32_t* row = matrix + (size_t)nRow * nCols;
+            // Two 12-bit candidates per 3 bytes, as in Kyber's Parse
+            for (size_t p = 0; p + 3 <= RATE && nFilled[k] < nCols; p += 3) {
+                uint32_t d1 = block[p] | ((uint32_t)(block[p + 1] & 0x0F) << 8);
+                uint32_t d2 = (block[p + 1] >> 4) | ((uint32_t)block[p + 2] << 4);
+                if (d1 < LATTICE_MODULUS)
+                    row[nFilled[k]++] = d1;
+                if (d2 < LATTICE_MODULUS && nFilled[k] < nCols)
+                    row[nFilled[k]++] = d2;
+            }
+            if (nFilled[k] < nCols)
+                fDone = false;
+        }
+    }
+}
+
+void ExpandLatticeMatrixXOF(const uint256& seed, uint32_t nRows, uint32_t nCols, uint32_t* matrix, int nThreads)
+{
+    assert(nRows <= 0x10000 && nCols < 0x10000);
+    uint32_t nGroups = (nRows + 3) / 4;
+    nThreads = std::max(1, std::min<int>(nThreads, nGroups));
+
+    auto expand = [&](int nThread) {
+        for (uint32_t group = nThread; group < nGroups; group += nThreads) {
+            ExpandLatticeRowsXOF(seed, group * 4, nRows, nCols, matrix);
+        }
+    };
+    std::vector<std::thread> vThreads;
+    for (int i = 1; i < nThreads; i++) {
+        vThreads.emplace_back(expand, i);
+    }
+    expand(0);
+    for (std::thread& thread : vThreads) {
+        thread.join();
+    }
+}
+
+std::shared_ptr<const LatticeMatrix> GetLatticeMatrixXOF(const uint256& seed)
+{
+    static std::mutex cs_xof;
+    static std::deque<std::pair<uint256, std::shared_ptr<const LatticeMatrix>>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock(cs_xof);
+        for (const auto& entry : cache) {
+            if (entry.first == seed) {
+                g_lattice_metrics.matrixCacheHits.Add();
+                return entry.second;
+            }
+        }
+    }
+
+    // Expand outside the lock; a racing thread may expand the same seed too
+    g_lattice_metrics.matrixCacheMisses.Add();
+    std::shared_ptr<const LatticeMatrix> matrix;
+    std::shared_ptr<const CLatticeMatrixMapping> mapping;
+    if (sizeof(LatticeMatrix) >= LATTICE_MATRIX_STORE_MIN_BYTES)
+        mapping = GetStoredLatticeMatrixXOF(seed, LATTICE_MATRIX_SIZE, LATTICE_MATRIX_SIZE);
+    if (mapping) {
+        // Points into the mapping, which stays mapped while the matrix is referenced
+        matrix = std::shared_ptr<const LatticeMatrix>(mapping, reinterpret_cast<const LatticeMatrix*>(mapping->Data()));
+    } else {
+        std::shared_ptr<LatticeMatrix> expanded = std::make_shared<LatticeMatrix>();
+        ExpandLatticeMatrixXOF(seed, LATTICE_MATRIX_SIZE, LATTICE_MATRIX_SIZE, (*expanded)[0].data());
+        matrix = expanded;
+    }
+
+    std::lock_guard<std::mutex> lock(cs_xof);
+    cache.emplace_back(seed, matrix);
+    if (cache.size() > LATTICE_XOF_CACHE_SIZE)
+        cache.pop_front();
+    return matrix;
+}
+
+/** Small {-1, 0, 1} error vector from an expanded error seed */
+static void ExpandErrorVector(const uint8_t error_seed[64], std::array<uint32_t, LATTICE_DIMENSION>& error)
+{
     for (int i = 0; i < LATTICE_DIMENSION; i++) {
         // Use different bytes for each error element
         uint8_t byte_val = error_seed[i % 64];
@@ -94,6 +209,18 @@ void GenerateErrorVector(const uint256& seed, std::array<uint32_t, LATTICE_DIMEN
     }
 }
 
+/**
+ * Generate error vector for Ring Learning With Errors
+ * Creates small random errors for cryptographic hardness
+ */
+void GenerateErrorVector(const uint256& seed, std::array<uint32_t, LATTICE_DIMENSION>& error) {
+    uint8_t error_seed[64];
+    
+    // Expand error seed
+    Keccak512_32(seed.begin(), error_seed);
+    ExpandErrorVector(error_seed, error);
+}
+
 /**
  * Lattice matrix-vector multiplication
  * Core operation of lattice-based cryptography
@@ -132,14 +259,159 @@ void PolynomialMultiply(const std::array<uint32_t, LATTICE_DIMENSION>& a,
     }
 }
 
+/**
+ * Transposed lattice matrix-vector multiplication
+ * Round kernel: result = A^T * vector
+ */
+void LatticeTransposeMultiply(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result) {
+    
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        int64_t sum = 0;
+        for (int j = 0; j < LATTICE_DIMENSION; j++) {
+            sum += static_cast<int64_t>(vector[j]) * static_cast<int64_t>(matrix[j][i]);
+        }
+        result[i] = ModularReduce(sum);
+    }
+}
+
+/**
+ * Ring multiplication in Zq[X]/(X^n + 1) by the first matrix row
+ * Round kernel: same result as PolynomialMultiply, reduced once per coefficient
+ */
+void LatticeRingMultiply(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result) {
+    
+    int64_t acc[LATTICE_DIMENSION] = {};
+    
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        for (int j = 0; j < LATTICE_DIMENSION; j++) {
+            int64_t product = static_cast<int64_t>(vector[i]) * static_cast<int64_t>(matrix[0][j]);
+            if (i + j < LATTICE_DIMENSION) {
+                acc[i + j] += product;
+            } else {
+                acc[i + j - LATTICE_DIMENSION] -= product;
+            }
+        }
+    }
+    
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        result[i] = ModularReduce(acc[i]);
+    }
+}
+
+/**
+ * Cyclic convolution in Zq[X]/(X^n - 1) by the last matrix row
+ * Round kernel: result = vector * a_(n-1)
+ */
+void LatticeCyclicMultiply(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result) {
+    
+    int64_t acc[LATTICE_DIMENSION] = {};
+    
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        for (int j = 0; j < LATTICE_DIMENSION; j++) {
+            acc[(i + j) % LATTICE_DIMENSION] += static_cast<int64_t>(vector[i]) *
+                                                static_cast<int64_t>(matrix[LATTICE_MATRIX_SIZE - 1][j]);
+        }
+    }
+    
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        result[i] = ModularReduce(acc[i]);
+    }
+}
+
+LatticeRoundKernel latticeMatrixMultiplyBackend = LatticeMatrixMultiply;
+
+// Round kernels in GetLatticeRound order; slot 0 is the matrix multiply backend
+static const LatticeRoundKernel latticeRoundKernels[LATTICE_ROUNDS] = {
+    nullptr,
+    LatticeTransposeMultiply,
+    LatticeRingMultiply,
+    LatticeCyclicMultiply,
+};
+
+/**
+ * Resolve the round kernel sequence for a PrevBlockHash
+ * Done once per block template, not once per nonce
+ */
+void BuildLatticeRoundTable(const uint256& PrevBlockHash, int nVersion, LatticeRoundTable& table) {
+    table.nVersion = nVersion;
+    table.hashPrevBlock = PrevBlockHash;
+    
+    if (nVersion >= LATTICE_POW_VERSION_XOF) {
+        table.matrixRef = GetLatticeMatrixXOF(PrevBlockHash);
+        table.matrix = table.matrixRef.get();
+        table.matrixSeed = PrevBlockHash;
+    } else {
+        InitializeLatticeMatrix(PrevBlockHash);
+        table.matrixSeed = lattice_matrix_seed;
+        table.matrixRef.reset();
+        table.matrix = &global_lattice_matrix;
+    }
+    
+    for (int round = 0; round < LATTICE_ROUNDS; round++) {
+        int selection = nVersion >= LATTICE_POW_VERSION_MIXED ? GetLatticeRound(PrevBlockHash, round) : 0;
+        table.kernel[round] = selection == 0 ? latticeMatrixMultiplyBackend : latticeRoundKernels[selection];
+    }
+}
+
+void HashLatticePOW4(const unsigned char* const header[4], const uint64_t* const prefix[4], const LatticeRoundTable& table, uint256 out[4])
+{
+    unsigned char stage[4][64];
+    unsigned char error_seed[4][64];
+    std::array<uint8_t, LATTICE_DIMENSION * 4> lattice_bytes[4];
+    const unsigned char* in[4];
+
+    const unsigned char* tail[4];
+    for (int k = 0; k < 4; k++)
+        tail[k] = header[k] + 72;
+    Keccak512_80x4(prefix, tail, stage);
+
+    for (int round = 0; round < LATTICE_ROUNDS; round++) {
+        // Error seeds are the upper halves of the previous stage
+        for (int k = 0; k < 4; k++)
+            in[k] = stage[k] + 32;
+        Keccak512_32x4(in, error_seed);
+
+        for (int k = 0; k < 4; k++) {
+            LatticeVector vector_a, vector_b, result_vector;
+            for (int i = 0; i < LATTICE_DIMENSION; i++) {
+                vector_a[i] = ModularReduce(ReadBE32(stage[k] + i * 4));
+            }
+            ExpandErrorVector(error_seed[k], vector_b);
+            table.kernel[round](vector_a, *table.matrix, result_vector);
+            for (int i = 0; i < LATTICE_DIMENSION; i++) {
+                WriteBE32(lattice_bytes[k].data() + i * 4, ModularReduce(result_vector[i] + vector_b[i]));
+            }
+            in[k] = lattice_bytes[k].data();
+        }
+        Keccak512_32x4(in, stage);
+        latticeOpHits[round] += 4;
+    }
+
+    for (int k = 0; k < 4; k++) {
+        memcpy(out[k].begin(), stage[k], 32);
+        if (fHashTrace.load(std::memory_order_relaxed))
+            TraceLatticePOW(table, header[k], BLOCK_HEADER_SIZE, out[k]);
+    }
+}
+
 /**
  * LATTICE-PoW Hash implementation for CHashLattice256
  */
 void CHashLattice256::Finalize(unsigned char hash[OUTPUT_SIZE]) {
-    // Apply Keccac to buffer
+    LatticeHash256(buffer.data(), buffer.size(), hash);
+}
+
+void LatticeHash256(const unsigned char* data, size_t len, unsigned char hash[CHashLattice256::OUTPUT_SIZE]) {
+    // Apply Keccac to the input
     uint8_t keccac_result[64];
-    sph_keccac512(&keccac, buffer.data(), buffer.size());
-    sph_keccac512_close(&keccac, keccac_result);
+    if (len == BLOCK_HEADER_SIZE) {
+        Keccak512_80(data, keccac_result);
+    } else {
+        sph_keccac512_context keccac;
+        sph_keccac512_init(&keccac);
+        sph_keccac512(&keccac, data, len);
+        sph_keccac512_close(&keccac, keccac_result);
+    }
     
     // Perform lattice operations on the result
     std::array<uint32_t, LATTICE_DIMENSION> lattice_vector, result_vector;
@@ -160,7 +432,7 @@ void CHashLattice256::Finalize(unsigned char hash[OUTPUT_SIZE]) {
     GenerateErrorVector(hash_seed, error_vector);
     
     // Perform final lattice operation
-    LatticeMatrixMultiply(lattice_vector, global_lattice_matrix, result_vector);
+    latticeMatrixMultiplyBackend(lattice_vector, global_lattice_matrix, result_vector);
     
     // Add error (RLWE hardness)
     for (int i = 0; i < LATTICE_DIMENSION; i++) {
@@ -177,14 +449,13 @@ void CHashLattice256::Finalize(unsigned char hash[OUTPUT_SIZE]) {
     }
     
     // Final Keccac for output
-    sph_keccac512_context final_ctx;
     uint8_t final_result[64];
-    sph_keccac512_init(&final_ctx);
-    sph_keccac512(&final_ctx, final_bytes.data(), final_bytes.size());
-    sph_keccac512_close(&final_ctx, final_result);
+    Keccak512_32(final_bytes.data(), final_result);
     
     // Copy first 32 bytes as final hash
-    memcpy(hash, final_result, OUTPUT_SIZE);
+    memcpy(hash, final_result, CHashLattice256::OUTPUT_SIZE);
+    if (fHashTrace.load(std::memory_order_relaxed))
+        TraceLatticeHash256(data, len, hash);
 }
 
 // Utility functions (unchanged from original)
@@ -225,6 +496,8 @@ unsigned int MurmurHash3(unsigned int nHashSeed, const std::vector<unsigned char
     h1 ^= h1 >> 16; h1 *= 0x85ebca6b;
     h1 ^= h1 >> 13; h1 *= 0xc2b2ae35;
     h1 ^= h1 >> 16;
+    if (fHashTrace.load(std::memory_order_relaxed))
+        TraceMurmurHash3(nHashSeed, vDataToHash, h1);
     return h1;
 }
 
@@ -238,6 +511,29 @@ void BIP32Hash(const ChainCode &chainCode, unsigned int nChild, unsigned char he
     CHMAC_SHA512(chainCode.begin(), chainCode.size()).Write(&header, 1).Write(data, 32).Write(num, 4).Finalize(output);
 }
 
+CBIP32Hasher::CBIP32Hasher(const ChainCode& chainCode) : keyed(chainCode.begin(), chainCode.size())
+{
+}
+
+void CBIP32Hasher::Derive(unsigned int nChild, unsigned char header, const unsigned char data[32], unsigned char output[64]) const
+{
+    unsigned char num[4];
+    WriteBE32(num, nChild);
+    CHMAC_SHA512(keyed).Write(&header, 1).Write(data, 32).Write(num, 4).Finalize(output);
+}
+
+void CBIP32Hasher::DeriveRange(unsigned int nChildBegin, size_t nCount, unsigned char header, const unsigned char data[32], unsigned char* output) const
+{
+    // header || data is shared by every child; it only sits in the block buffer
+    CHMAC_SHA512 parent(keyed);
+    parent.Write(&header, 1).Write(data, 32);
+    unsigned char num[4];
+    for (size_t i = 0; i < nCount; i++) {
+        WriteBE32(num, nChildBegin + (unsigned int)i);
+        CHMAC_SHA512(parent).Write(num, 4).Finalize(output + 64 * i);
+    }
+}
+
 // SipHash implementation (unchanged from original)
 #define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
 #define SIPROUND do { \
@@ -314,7 +610,10 @@ uint64_t SipHashUint256(uint64_t k0, uint64_t k1, const uint256& val)
     d = val.GetUint64(3); v3 ^= d; SIPROUND; SIPROUND; v0 ^= d;
     v3 ^= ((uint64_t)4) << 59; SIPROUND; SIPROUND; v0 ^= ((uint64_t)4) << 59;
     v2 ^= 0xFF; SIPROUND; SIPROUND; SIPROUND; SIPROUND;
-    return v0 ^ v1 ^ v2 ^ v3;
+    uint64_t result = v0 ^ v1 ^ v2 ^ v3;
+    if (fHashTrace.load(std::memory_order_relaxed))
+        TraceSipHash(k0, k1, val, nullptr, result);
+    return result;
 }
 
 uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint32_t extra)
@@ -331,5 +630,8 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     d = val.GetUint64(3); v3 ^= d; SIPROUND; SIPROUND; v0 ^= d;
     d = (((uint64_t)36) << 56) | extra; v3 ^= d; SIPROUND; SIPROUND; v0 ^= d;
     v2 ^= 0xFF; SIPROUND; SIPROUND; SIPROUND; SIPROUND;
-    return v0 ^ v1 ^ v2 ^ v3;
+    uint64_t result = v0 ^ v1 ^ v2 ^ v3;
+    if (fHashTrace.load(std::memory_order_relaxed))
+        TraceSipHash(k0, k1, val, &extra, result);
+    return result;
 }
@@ -11,8 +11,14 @@
 #include <chrono>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <memory>
+#include "crypto/common.h"
+#include "crypto/hmac_sha512.h"
 #include "crypto/ripemd160.h"
 #include "crypto/sha256.h"
+#include "crypto/sha3.h"
+#include "hashtrace.h"
 #include "prevector.h"
 #include "serialize.h"
 #include "uint256.h"
@@ -37,11 +43,27 @@ const uint32_t LATTICE_DIMENSION = 8;           // Ring dimension (optimized for
 const uint32_t LATTICE_MATRIX_SIZE = 8;         // Matrix size for operations
 const uint32_t LATTICE_ROUNDS = 4;              // Number of lattice rounds
 
+// LATTICE-PoW algorithm versions
+const int LATTICE_POW_VERSION_SINGLE = 1;       // LatticeMatrixMultiply in every round
+const int LATTICE_POW_VERSION_MIXED = 2;        // Round kernel selected by GetLatticeRound
+const int LATTICE_POW_VERSION_XOF = 3;          // MIXED rounds over a per-block ExpandLatticeMatrixXOF matrix
+
+/** Seed the genesis procedure initializes the v1/v2 matrix with before hashing anything */
+static const char* const LATTICE_MATRIX_DEFAULT_SEED = "0x0000000000000000000000000000000000000000000000000000000000000001";
+
+/** Recent XOF-expanded matrices kept by GetLatticeMatrixXOF */
+const size_t LATTICE_XOF_CACHE_SIZE = 8;
+
+typedef std::array<uint32_t, LATTICE_DIMENSION> LatticeVector;
+typedef std::array<std::array<uint32_t, LATTICE_MATRIX_SIZE>, LATTICE_MATRIX_SIZE> LatticeMatrix;
+
 // Global contexts for lattice operations
 GLOBAL sph_keccak512_context z_keccak_lattice;
 GLOBAL std::array<std::array<uint32_t, LATTICE_MATRIX_SIZE>, LATTICE_MATRIX_SIZE> global_lattice_matrix;
-GLOBAL bool lattice_initialized;
+GLOBAL std::atomic<bool> lattice_initialized;
+GLOBAL uint256 lattice_matrix_seed;                 // Set once, before lattice_initialized
 
+/** Reset the v1/v2 matrix; only while no thread is hashing */
 #define fillz_lattice() do { \
     sph_keccak512_init(&z_keccak_lattice); \
     lattice_initialized = false; \
@@ -50,7 +72,6 @@ GLOBAL bool lattice_initialized;
 /** A hasher class for LATTICE-PoW 256-bit hash. */
 class CHashLattice256 {
 private:
-    sph_keccak512_context keccak;
     std::vector<uint8_t> buffer;
     
 public:
@@ -68,12 +89,14 @@ public:
     }
     
     CHashLattice256& Reset() {
-        sph_keccak512_init(&keccac);
         buffer.clear();
         return *this;
     }
 };
 
+/** CHashLattice256 over one contiguous input, without the intermediate buffer */
+void LatticeHash256(const unsigned char* data, size_t len, unsigned char hash[CHashLattice256::OUTPUT_SIZE]);
+
 class CHashLattice160 {
 private:
     CHashLattice256 lattice;
@@ -99,6 +122,13 @@ public:
 };
 
 // Lattice operation functions
+
+/**
+ * Expand global_lattice_matrix from seed. Only the first call does anything,
+ * so processes that build v1/v2 round tables from several threads call it
+ * with the chain's seed before starting them; otherwise the matrix is seeded
+ * by whichever hashPrevBlock gets here first.
+ */
 void InitializeLatticeMatrix(const uint256& seed);
 void LatticeMatrixMultiply(const std::array<uint32_t, LATTICE_DIMENSION>& vector,
                           const std::array<std::array<uint32_t, LATTICE_DIMENSION>, LATTICE_DIMENSION>& matrix,
@@ -109,6 +139,49 @@ void PolynomialMultiply(const std::array<uint32_t, LATTICE_DIMENSION>& a,
                        std::array<uint32_t, LATTICE_DIMENSION>& result);
 uint32_t ModularReduce(int64_t value);
 
+/**
+ * Kyber GenA-style matrix expansion: row i is rejection-sampled mod
+ * LATTICE_MODULUS from the SHAKE128 stream of seed || LE16(i) || LE16(nCols),
+ * so each row costs a few Keccak permutations instead of one Keccak-512 per
+ * element. Works for any dimension; rows are squeezed four at a time with
+ * KeccakF4 and the row groups are split over nThreads.
+ */
+void ExpandLatticeMatrixXOF(const uint256& seed, uint32_t nRows, uint32_t nCols, uint32_t* matrix, int nThreads = 1);
+
+/** ExpandLatticeMatrixXOF matrix for seed, shared from a cache of recent seeds */
+std::shared_ptr<const LatticeMatrix> GetLatticeMatrixXOF(const uint256& seed);
+
+// Round kernels for LATTICE_POW_VERSION_MIXED, indexed by GetLatticeRound
+void LatticeTransposeMultiply(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result);
+void LatticeRingMultiply(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result);
+void LatticeCyclicMultiply(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result);
+
+typedef void (*LatticeRoundKernel)(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result);
+
+/**
+ * Matrix multiply backend picked by LatticeAutoTune; defaults to
+ * LatticeMatrixMultiply. BuildLatticeRoundTable copies it into the table and
+ * nothing synchronizes the write, so tune once at startup, before any hashing
+ * thread starts or any round table is built.
+ */
+extern LatticeRoundKernel latticeMatrixMultiplyBackend;
+
+/**
+ * Round kernels and matrix resolved once per PrevBlockHash.
+ * HashLatticePOW calls through this table, so the per-nonce loop never
+ * branches on round selection.
+ */
+struct LatticeRoundTable {
+    int nVersion;
+    uint256 hashPrevBlock;
+    uint256 matrixSeed;                                 // hashPrevBlock for XOF, lattice_matrix_seed otherwise
+    const LatticeMatrix* matrix;
+    std::shared_ptr<const LatticeMatrix> matrixRef;     // Keeps an XOF matrix alive
+    LatticeRoundKernel kernel[LATTICE_ROUNDS];
+};
+
+void BuildLatticeRoundTable(const uint256& PrevBlockHash, int nVersion, LatticeRoundTable& table);
+
 /** Compute the 256-bit hash of an object using LATTICE-PoW. */
 template<typename T1>
 inline uint256 Hash(const T1 pbegin, const T1 pend)
@@ -152,8 +225,17 @@ inline uint160 Hash160(const T1 pbegin, const T1 pend)
 {
     static unsigned char pblank[1] = {};
     uint160 result;
-    CHashLattice160().Write(pbegin == pend ? pblank : (const unsigned char*)&pbegin[0], (pend - pbegin) * sizeof(pbegin[0]))
-              .Finalize((unsigned char*)&result);
+    const unsigned char* data = pbegin == pend ? pblank : (const unsigned char*)&pbegin[0];
+    size_t len = (pend - pbegin) * sizeof(pbegin[0]);
+    if (fHashTrace.load(std::memory_order_relaxed)) {
+        {
+            CHashTraceNested nested;
+            CHashLattice160().Write(data, len).Finalize((unsigned char*)&result);
+        }
+        TraceHash160(data, len, result);
+        return result;
+    }
+    CHashLattice160().Write(data, len).Finalize((unsigned char*)&result);
     return result;
 }
 
@@ -241,10 +323,63 @@ uint256 SerializeHash(const T& obj, int nType=SER_GETHASH, int nVersion=PROTOCOL
     return ss.GetHash();
 }
 
+static const size_t BLOCK_HEADER_SIZE = 80;
+
+/**
+ * Write a block header's fixed 80-byte serialization (nVersion,
+ * hashPrevBlock, hashMerkleRoot, nTime, nBits, nNonce) into out.
+ * Templated so this file does not depend on primitives/block.h.
+ */
+template<typename Header>
+inline void PackBlockHeader(const Header& header, unsigned char out[BLOCK_HEADER_SIZE])
+{
+    WriteLE32(out, (uint32_t)header.nVersion);
+    memcpy(out + 4, header.hashPrevBlock.begin(), 32);
+    memcpy(out + 36, header.hashMerkleRoot.begin(), 32);
+    WriteLE32(out + 68, header.nTime);
+    WriteLE32(out + 72, header.nBits);
+    WriteLE32(out + 76, header.nNonce);
+}
+
+/**
+ * SerializeHash(header) without CHashWriter: the header is packed on the
+ * stack and hashed in one call instead of one buffered write per field.
+ */
+template<typename Header>
+inline uint256 SerializeHeaderHash(const Header& header)
+{
+    unsigned char data[BLOCK_HEADER_SIZE];
+    PackBlockHeader(header, data);
+    uint256 result;
+    LatticeHash256(data, sizeof(data), result.begin());
+    return result;
+}
+
 // Maintain compatibility functions
 unsigned int MurmurHash3(unsigned int nHashSeed, const std::vector<unsigned char>& vDataToHash);
 void BIP32Hash(const ChainCode &chainCode, unsigned int nChild, unsigned char header, const unsigned char data[32], unsigned char output[64]);
 
+/**
+ * BIP32Hash for many children of one chain code, e.g. gap-limit scans and
+ * address pre-generation. The HMAC key pads are compressed once here; each
+ * derivation starts from a copy of that state and runs the two remaining
+ * SHA-512 compressions instead of four.
+ */
+class CBIP32Hasher
+{
+public:
+    explicit CBIP32Hasher(const ChainCode& chainCode);
+
+    /** Same output as BIP32Hash(chainCode, nChild, header, data, output) */
+    void Derive(unsigned int nChild, unsigned char header, const unsigned char data[32], unsigned char output[64]) const;
+
+    /** Children nChildBegin .. nChildBegin + nCount - 1 of one parent key, 64 output bytes each */
+    void DeriveRange(unsigned int nChildBegin, size_t nCount, unsigned char header, const unsigned char data[32], unsigned char* output) const;
+
+private:
+    CHMAC_SHA512 keyed;
+};
+
 /** SipHash-2-4 (unchanged from original) */
 class CSipHasher
 {
@@ -272,14 +407,15 @@ inline int GetLatticeRound(const uint256 PrevBlockHash, int round) {
     return(roundSelection % LATTICE_ROUNDS);
 }
 
-extern double latticeOpTotal[LATTICE_ROUNDS];
-extern int latticeOpHits[LATTICE_ROUNDS];
+/** Per-thread round statistics, e.g. for the genesis procedure */
+extern thread_local double latticeOpTotal[LATTICE_ROUNDS];
+extern thread_local int latticeOpHits[LATTICE_ROUNDS];
 
 /**
- * LATTICE-PoW Hash Function
+ * LATTICE-PoW Hash Function using a prepared round table
  */
 template<typename T1>
-inline uint256 HashLatticePOW(const T1 pbegin, const T1 pend, const uint256 PrevBlockHash)
+inline uint256 HashLatticePOW(const T1 pbegin, const T1 pend, const LatticeRoundTable& table)
 {
     // Initialize lattice contexts
     sph_keccac512_context ctx_keccac;
@@ -293,12 +429,13 @@ inline uint256 HashLatticePOW(const T1 pbegin, const T1 pend, const uint256 Prev
     toHash = (pbegin == pend ? pblank : static_cast<const void*>(&pbegin[0]));
     lenToHash = (pend - pbegin) * sizeof(pbegin[0]);
     
-    sph_keccac512_init(&ctx_keccac);
-    sph_keccac512(&ctx_keccac, toHash, lenToHash);
-    sph_keccac512_close(&ctx_keccac, static_cast<void*>(&hash_stages[0]));
-    
-    // Initialize lattice matrix from previous block hash
-    InitializeLatticeMatrix(PrevBlockHash);
+    if (lenToHash == (int)BLOCK_HEADER_SIZE) {
+        Keccak512_80(static_cast<const unsigned char*>(toHash), hash_stages[0].data());
+    } else {
+        sph_keccac512_init(&ctx_keccac);
+        sph_keccac512(&ctx_keccac, toHash, lenToHash);
+        sph_keccac512_close(&ctx_keccac, static_cast<void*>(&hash_stages[0]));
+    }
     
     // Perform LATTICE_ROUNDS of lattice operations
     for (int round = 0; round < LATTICE_ROUNDS; round++) 
@@ -319,8 +456,8 @@ inline uint256 HashLatticePOW(const T1 pbegin, const T1 pend, const uint256 Prev
         memcpy(&round_seed, &hash_stages[round][32], 32);
         GenerateErrorVector(round_seed, vector_b);
         
-        // Perform lattice operation: matrix multiplication + error
-        LatticeMatrixMultiply(vector_a, global_lattice_matrix, result_vector);
+        // Perform lattice operation: round kernel + error
+        table.kernel[round](vector_a, *table.matrix, result_vector);
         
         // Add error vector (RLWE)
         for (int i = 0; i < LATTICE_DIMENSION; i++) {
@@ -337,9 +474,7 @@ inline uint256 HashLatticePOW(const T1 pbegin, const T1 pend, const uint256 Prev
         }
         
         // Final Keccac hash for this round
-        sph_keccac512_init(&ctx_keccac);
-        sph_keccac512(&ctx_keccac, lattice_bytes.data(), lattice_bytes.size());
-        sph_keccac512_close(&ctx_keccac, static_cast<void*>(&hash_stages[round + 1]));
+        Keccak512_32(lattice_bytes.data(), hash_stages[round + 1].data());
         
         // Update statistics
         latticeOpHits[round % LATTICE_ROUNDS]++;
@@ -348,7 +483,51 @@ inline uint256 HashLatticePOW(const T1 pbegin, const T1 pend, const uint256 Prev
     // Final result: trim to 256 bits
     uint256 final_result;
     memcpy(&final_result, &hash_stages[LATTICE_ROUNDS], 32);
+    if (fHashTrace.load(std::memory_order_relaxed))
+        TraceLatticePOW(table, toHash, lenToHash, final_result);
     return final_result;
 }
 
+/**
+ * LATTICE-PoW Hash Function
+ */
+template<typename T1>
+inline uint256 HashLatticePOW(const T1 pbegin, const T1 pend, const uint256 PrevBlockHash)
+{
+    // Initialize lattice matrix from previous block hash
+    LatticeRoundTable table;
+    BuildLatticeRoundTable(PrevBlockHash, LATTICE_POW_VERSION_SINGLE, table);
+    return HashLatticePOW(pbegin, pend, table);
+}
+
+/**
+ * HashLatticePOW of four 80-byte headers at once, with every Keccak run
+ * four-wide through KeccakF4. prefix[k] is the Keccak512_80Prefix state of
+ * header[k]'s first 72 bytes, so headers sharing a prefix (same miner,
+ * merkle root and time) need it only once. Results match HashLatticePOW.
+ */
+void HashLatticePOW4(const unsigned char* const header[4], const uint64_t* const prefix[4], const LatticeRoundTable& table, uint256 out[4]);
+
+/** LATTICE-PoW hash of a block header through a prepared round table */
+template<typename Header>
+inline uint256 HashBlockHeader(const Header& header, const LatticeRoundTable& table)
+{
+    unsigned char data[BLOCK_HEADER_SIZE];
+    PackBlockHeader(header, data);
+    return HashLatticePOW(data, data + BLOCK_HEADER_SIZE, table);
+}
+
+/**
+ * LATTICE-PoW hash of a block header, e.g. for CBlockHeader::GetHash().
+ * Same result as HashLatticePOW(BEGIN(nVersion), END(nNonce), hashPrevBlock)
+ * but packed explicitly, so it does not rely on the in-memory field layout.
+ */
+template<typename Header>
+inline uint256 HashBlockHeader(const Header& header, int nVersion = LATTICE_POW_VERSION_SINGLE)
+{
+    LatticeRoundTable table;
+    BuildLatticeRoundTable(header.hashPrevBlock, nVersion, table);
+    return HashBlockHeader(header, table);
+}
+
 #endif // LATTICE_POW_HASH_H
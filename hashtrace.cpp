@@ -0,0 +1,418 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "hashtrace.h"
+
+#include "hash.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+
+std::atomic<bool> fHashTrace(false);
+
+static const char* const HASH_TRACE_TYPE_NAMES[NUM_HASH_TRACE_TYPES] = {
+    "", "round_table", "lattice_pow", "lattice256", "hash160", "siphash", "siphash_extra", "murmur3", "matrix_seed"};
+
+const char* GetHashTraceTypeName(HashTraceType type)
+{
+    return type > 0 && type < NUM_HASH_TRACE_TYPES ? HASH_TRACE_TYPE_NAMES[type] : "unknown";
+}
+
+/**
+ * One thread's pending records. Only the owner appends; StopHashTrace and
+ * the owner's exit take what is left. Lock order is csTrace, then cs.
+ */
+struct TraceBuffer {
+    std::mutex cs;
+    std::vector<unsigned char> vData;
+    uint64_t nGeneration;           // Capture the data belongs to
+    bool fTable;                    // Round table already recorded in this chunk
+    bool fSeed;                     // Matrix seed already recorded in this chunk
+    int nTableVersion;
+    uint256 tableHash;
+    uint32_t nSkip;                 // Owner only: calls left until the next sample
+    int nNested;                    // Owner only: open CHashTraceNested scopes
+
+    TraceBuffer();
+    ~TraceBuffer();
+};
+
+static std::mutex csTrace;
+static FILE* fileTrace = nullptr;
+static std::set<TraceBuffer*> setBuffers;
+static uint64_t nTraceMaxBytes = 0;
+static std::atomic<uint64_t> nTraceGeneration(0);
+static std::atomic<uint64_t> nTraceBytes(0);
+static std::atomic<uint32_t> nTraceSampleRate(1);
+
+/** Write one chunk if its capture is still open; requires csTrace */
+static void WriteChunkLocked(const std::vector<unsigned char>& vChunk, uint64_t nGeneration)
+{
+    if (fileTrace == nullptr || nGeneration != nTraceGeneration || vChunk.empty())
+        return;
+    unsigned char size[4];
+    WriteLE32(size, vChunk.size());
+    if (fwrite(size, 1, 4, fileTrace) != 4 || fwrite(vChunk.data(), 1, vChunk.size(), fileTrace) != vChunk.size()) {
+        LogPrintf("Hash trace: write failed, capture stopped\n");
+        fHashTrace = false;
+        fclose(fileTrace);
+        fileTrace = nullptr;
+        return;
+    }
+    nTraceBytes += 4 + vChunk.size();
+    if (nTraceBytes >= nTraceMaxBytes) {
+        LogPrintf("Hash trace: size limit of %u bytes reached, capture stopped\n", nTraceMaxBytes);
+        fHashTrace = false;
+        fclose(fileTrace);
+        fileTrace = nullptr;
+    }
+}
+
+/** Move a buffer's records out as one chunk; requires buffer.cs */
+static void TakeChunk(TraceBuffer& buffer, std::vector<unsigned char>& vChunk)
+{
+    vChunk.swap(buffer.vData);
+    buffer.vData.clear();
+    buffer.fTable = false;
+    buffer.fSeed = false;
+}
+
+TraceBuffer::TraceBuffer() : nGeneration(0), fTable(false), fSeed(false), nTableVersion(0), nSkip(0), nNested(0)
+{
+    vData.reserve(HASH_TRACE_CHUNK_SIZE + 256);
+    std::lock_guard<std::mutex> lock(csTrace);
+    setBuffers.insert(this);
+}
+
+TraceBuffer::~TraceBuffer()
+{
+    std::lock_guard<std::mutex> lock(csTrace);
+    std::vector<unsigned char> vChunk;
+    {
+        std::lock_guard<std::mutex> lockBuffer(cs);
+        TakeChunk(*this, vChunk);
+    }
+    WriteChunkLocked(vChunk, nGeneration);
+    setBuffers.erase(this);
+}
+
+static TraceBuffer& GetTraceBuffer()
+{
+    static thread_local std::unique_ptr<TraceBuffer> buffer;
+    if (!buffer)
+        buffer.reset(new TraceBuffer());
+    return *buffer;
+}
+
+/** Sampling decision for the calling thread's next call */
+static bool Sample(TraceBuffer& buffer)
+{
+    if (buffer.nNested > 0)
+        return false;
+    if (buffer.nSkip > 0) {
+        buffer.nSkip--;
+        return false;
+    }
+    buffer.nSkip = nTraceSampleRate.load(std::memory_order_relaxed) - 1;
+    return true;
+}
+
+static void PutVarInt(std::vector<unsigned char>& v, uint64_t n)
+{
+    while (n >= 0x80) {
+        v.push_back((unsigned char)(n | 0x80));
+        n >>= 7;
+    }
+    v.push_back((unsigned char)n);
+}
+
+static void PutLE32(std::vector<unsigned char>& v, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteLE32(buf, n);
+    v.insert(v.end(), buf, buf + 4);
+}
+
+static void PutLE64(std::vector<unsigned char>& v, uint64_t n)
+{
+    unsigned char buf[8];
+    WriteLE64(buf, n);
+    v.insert(v.end(), buf, buf + 8);
+}
+
+static void AppendRecord(TraceBuffer& buffer, HashTraceType type, const unsigned char* prefix, size_t nPrefix,
+                         const unsigned char* data, size_t nData, uint64_t nCheck, const LatticeRoundTable* table)
+{
+    std::vector<unsigned char> vChunk;
+    uint64_t nGeneration;
+    {
+        std::lock_guard<std::mutex> lock(buffer.cs);
+        nGeneration = nTraceGeneration.load();
+        if (buffer.nGeneration != nGeneration) {
+            // Left over from an earlier capture
+            buffer.vData.clear();
+            buffer.fTable = false;
+            buffer.fSeed = false;
+            buffer.nGeneration = nGeneration;
+        }
+        std::vector<unsigned char>& v = buffer.vData;
+        // lattice256 and v1/v2 round tables hash through the matrix this seeds
+        if (!buffer.fSeed && lattice_initialized.load(std::memory_order_acquire)) {
+            v.push_back(HASH_TRACE_MATRIX_SEED);
+            PutVarInt(v, 32);
+            v.insert(v.end(), lattice_matrix_seed.begin(), lattice_matrix_seed.end());
+            PutLE64(v, 0);
+            buffer.fSeed = true;
+        }
+        if (table && (!buffer.fTable || buffer.nTableVersion != table->nVersion || buffer.tableHash != table->hashPrevBlock)) {
+            v.push_back(HASH_TRACE_ROUND_TABLE);
+            PutVarInt(v, 36);
+            PutLE32(v, (uint32_t)table->nVersion);
+            v.insert(v.end(), table->hashPrevBlock.begin(), table->hashPrevBlock.end());
+            PutLE64(v, 0);
+            buffer.fTable = true;
+            buffer.nTableVersion = table->nVersion;
+            buffer.tableHash = table->hashPrevBlock;
+        }
+        v.push_back(type);
+        PutVarInt(v, nPrefix + nData);
+        v.insert(v.end(), prefix, prefix + nPrefix);
+        v.insert(v.end(), data, data + nData);
+        PutLE64(v, nCheck);
+        if (v.size() >= HASH_TRACE_CHUNK_SIZE)
+            TakeChunk(buffer, vChunk);
+    }
+    if (!vChunk.empty()) {
+        std::lock_guard<std::mutex> lock(csTrace);
+        WriteChunkLocked(vChunk, nGeneration);
+    }
+}
+
+CHashTraceNested::CHashTraceNested()
+{
+    GetTraceBuffer().nNested++;
+}
+
+CHashTraceNested::~CHashTraceNested()
+{
+    GetTraceBuffer().nNested--;
+}
+
+bool StartHashTrace(const std::string& strPath, uint64_t nMaxBytes, uint32_t nSampleRate)
+{
+    std::lock_guard<std::mutex> lock(csTrace);
+    if (fileTrace != nullptr) {
+        LogPrintf("Hash trace: already capturing\n");
+        return false;
+    }
+    FILE* file = fopen(strPath.c_str(), "wb");
+    if (file == nullptr) {
+        LogPrintf("Hash trace: unable to open %s\n", strPath);
+        return false;
+    }
+    unsigned char header[12];
+    memcpy(header, HASH_TRACE_MAGIC, 8);
+    WriteLE32(header + 8, HASH_TRACE_FORMAT_VERSION);
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) {
+        fclose(file);
+        return false;
+    }
+    fileTrace = file;
+    nTraceMaxBytes = nMaxBytes;
+    nTraceBytes = sizeof(header);
+    nTraceSampleRate = std::max<uint32_t>(nSampleRate, 1);
+    nTraceGeneration++;
+    fHashTrace = true;
+    LogPrintf("Hash trace: capturing to %s, 1 in %u calls, up to %u bytes\n", strPath, nTraceSampleRate.load(), nMaxBytes);
+    return true;
+}
+
+void StopHashTrace()
+{
+    std::lock_guard<std::mutex> lock(csTrace);
+    fHashTrace = false;
+    if (fileTrace == nullptr)
+        return;
+    uint64_t nGeneration = nTraceGeneration;
+    for (TraceBuffer* buffer : setBuffers) {
+        std::vector<unsigned char> vChunk;
+        {
+            std::lock_guard<std::mutex> lockBuffer(buffer->cs);
+            if (buffer->nGeneration != nGeneration)
+                continue;
+            TakeChunk(*buffer, vChunk);
+        }
+        WriteChunkLocked(vChunk, nGeneration);
+    }
+    if (fileTrace != nullptr) {
+        fclose(fileTrace);
+        fileTrace = nullptr;
+    }
+    LogPrintf("Hash trace: stopped after %u bytes\n", nTraceBytes.load());
+}
+
+uint64_t GetHashTraceBytes()
+{
+    return nTraceBytes;
+}
+
+void TraceLatticePOW(const LatticeRoundTable& table, const void* data, size_t len, const uint256& result)
+{
+    TraceBuffer& buffer = GetTraceBuffer();
+    if (Sample(buffer))
+        AppendRecord(buffer, HASH_TRACE_LATTICE_POW, nullptr, 0, (const unsigned char*)data, len, ReadLE64(result.begin()), &table);
+}
+
+void TraceLatticeHash256(const unsigned char* data, size_t len, const unsigned char* hash)
+{
+    TraceBuffer& buffer = GetTraceBuffer();
+    if (Sample(buffer))
+        AppendRecord(buffer, HASH_TRACE_LATTICE256, nullptr, 0, data, len, ReadLE64(hash), nullptr);
+}
+
+void TraceHash160(const unsigned char* data, size_t len, const uint160& result)
+{
+    TraceBuffer& buffer = GetTraceBuffer();
+    if (Sample(buffer))
+        AppendRecord(buffer, HASH_TRACE_HASH160, nullptr, 0, data, len, ReadLE64(result.begin()), nullptr);
+}
+
+void TraceSipHash(uint64_t k0, uint64_t k1, const uint256& val, const uint32_t* extra, uint64_t result)
+{
+    TraceBuffer& buffer = GetTraceBuffer();
+    if (!Sample(buffer))
+        return;
+    unsigned char prefix[52];
+    WriteLE64(prefix, k0);
+    WriteLE64(prefix + 8, k1);
+    memcpy(prefix + 16, val.begin(), 32);
+    if (extra)
+        WriteLE32(prefix + 48, *extra);
+    AppendRecord(buffer, extra ? HASH_TRACE_SIPHASH_EXTRA : HASH_TRACE_SIPHASH, prefix, extra ? 52 : 48, nullptr, 0, result, nullptr);
+}
+
+void TraceMurmurHash3(unsigned int nHashSeed, const std::vector<unsigned char>& vData, unsigned int result)
+{
+    TraceBuffer& buffer = GetTraceBuffer();
+    if (!Sample(buffer))
+        return;
+    unsigned char prefix[4];
+    WriteLE32(prefix, nHashSeed);
+    AppendRecord(buffer, HASH_TRACE_MURMUR3, prefix, 4, vData.data(), vData.size(), result, nullptr);
+}
+
+bool ReadHashTrace(const std::string& strPath, HashTraceFile& trace, std::string& strError)
+{
+    std::ifstream file(strPath, std::ios::binary);
+    if (!file.is_open()) {
+        strError = "cannot open " + strPath;
+        return false;
+    }
+    trace.vData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    trace.vRecords.clear();
+    trace.fMatrixSeed = false;
+    const std::vector<unsigned char>& v = trace.vData;
+    if (v.size() < 12 || memcmp(v.data(), HASH_TRACE_MAGIC, 8) != 0) {
+        strError = "not a hash trace";
+        return false;
+    }
+    if (ReadLE32(v.data() + 8) != HASH_TRACE_FORMAT_VERSION) {
+        strError = strprintf("unsupported format %u", ReadLE32(v.data() + 8));
+        return false;
+    }
+
+    size_t nPos = 12;
+    while (nPos < v.size()) {
+        if (v.size() - nPos < 4) {
+            strError = strprintf("truncated chunk at offset %u", nPos);
+            return false;
+        }
+        size_t nEnd = nPos + 4 + ReadLE32(v.data() + nPos);
+        if (nEnd > v.size()) {
+            strError = strprintf("truncated chunk at offset %u", nPos);
+            return false;
+        }
+        nPos += 4;
+        // Round tables never carry over from another chunk
+        bool fTable = false;
+        int nPowVersion = 0;
+        uint256 hashPrevBlock;
+        while (nPos < nEnd) {
+            size_t nRecord = nPos;
+            unsigned int type = v[nPos++];
+            uint64_t nLength = 0;
+            for (int nShift = 0; nShift < 64; nShift += 7) {
+                if (nPos >= nEnd)
+                    break;
+                unsigned char ch = v[nPos++];
+                nLength |= (uint64_t)(ch & 0x7f) << nShift;
+                if (!(ch & 0x80))
+                    break;
+            }
+            if (nPos > nEnd || nEnd - nPos < nLength + 8) {
+                strError = strprintf("truncated record at offset %u", nRecord);
+                return false;
+            }
+            bool fValid;
+            switch (type) {
+            case HASH_TRACE_ROUND_TABLE:
+            case HASH_TRACE_SIPHASH:
+            case HASH_TRACE_SIPHASH_EXTRA:
+                fValid = nLength == (type == HASH_TRACE_ROUND_TABLE ? 36 : type == HASH_TRACE_SIPHASH ? 48 : 52);
+                break;
+            case HASH_TRACE_LATTICE_POW:
+                fValid = fTable;
+                break;
+            case HASH_TRACE_MATRIX_SEED:
+                fValid = nLength == 32;
+                break;
+            case HASH_TRACE_MURMUR3:
+                fValid = nLength >= 4;
+                break;
+            case HASH_TRACE_LATTICE256:
+            case HASH_TRACE_HASH160:
+                fValid = true;
+                break;
+            default:
+                fValid = false;
+            }
+            if (!fValid) {
+                strError = strprintf("bad %s record at offset %u", GetHashTraceTypeName((HashTraceType)type), nRecord);
+                return false;
+            }
+            if (type == HASH_TRACE_ROUND_TABLE) {
+                fTable = true;
+                nPowVersion = (int32_t)ReadLE32(v.data() + nPos);
+                memcpy(hashPrevBlock.begin(), v.data() + nPos + 4, 32);
+            } else if (type == HASH_TRACE_MATRIX_SEED) {
+                uint256 seed;
+                memcpy(seed.begin(), v.data() + nPos, 32);
+                if (trace.fMatrixSeed && seed != trace.matrixSeed) {
+                    strError = strprintf("second matrix seed at offset %u", nRecord);
+                    return false;
+                }
+                trace.fMatrixSeed = true;
+                trace.matrixSeed = seed;
+            } else {
+                HashTraceRecord record;
+                record.type = (HashTraceType)type;
+                record.nOffset = nPos;
+                record.nLength = nLength;
+                record.nCheck = ReadLE64(v.data() + nPos + nLength);
+                record.nPowVersion = nPowVersion;
+                record.hashPrevBlock = hashPrevBlock;
+                trace.vRecords.push_back(record);
+            }
+            nPos += nLength + 8;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_HASHTRACE_H
+#define LATTICE_HASHTRACE_H
+
+#include "uint256.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct LatticeRoundTable;
+
+static const uint64_t DEFAULT_HASH_TRACE_MAX_BYTES = (uint64_t)1 << 30;
+/** Per-thread buffer size; each flush is one self-contained chunk of the trace */
+static const size_t HASH_TRACE_CHUNK_SIZE = 1 << 16;
+static const uint32_t HASH_TRACE_FORMAT_VERSION = 2;
+static const char HASH_TRACE_MAGIC[8] = {'L', 'A', 'T', 'T', 'R', 'A', 'C', 'E'};
+
+/**
+ * Trace file: magic, format version (LE32), then chunks. A chunk is its
+ * size (LE32) followed by records; one thread wrote it and it does not
+ * depend on any other chunk. A record is its type, the payload length as
+ * a LEB128 varint, the payload, and the first 8 bytes of the output (LE64
+ * for integer results) so replays can check they still agree.
+ */
+enum HashTraceType : uint8_t {
+    HASH_TRACE_ROUND_TABLE = 1,     // [LE32 pow version][32 prev block]; no output. Applies to the rest of the chunk
+    HASH_TRACE_LATTICE_POW,         // [input] hashed through the chunk's current round table
+    HASH_TRACE_LATTICE256,          // [input] CHashLattice256 and LatticeHash256
+    HASH_TRACE_HASH160,             // [input]; its inner LatticeHash256 is not recorded
+    HASH_TRACE_SIPHASH,             // [LE64 k0][LE64 k1][32 val]
+    HASH_TRACE_SIPHASH_EXTRA,       // [LE64 k0][LE64 k1][32 val][LE32 extra]
+    HASH_TRACE_MURMUR3,             // [LE32 seed][input]
+    HASH_TRACE_MATRIX_SEED,         // [32 seed]; no output. v1/v2 matrix seed, once per chunk after it was set
+    NUM_HASH_TRACE_TYPES
+};
+
+const char* GetHashTraceTypeName(HashTraceType type);
+
+/** Set while a capture is running; the hash.h hooks check nothing else */
+extern std::atomic<bool> fHashTrace;
+
+/**
+ * Start capturing into strPath, keeping one call in nSampleRate per thread.
+ * Capture stops by itself once nMaxBytes have been written.
+ */
+bool StartHashTrace(const std::string& strPath, uint64_t nMaxBytes = DEFAULT_HASH_TRACE_MAX_BYTES, uint32_t nSampleRate = 1);
+/** Flush every thread's buffer and close the file */
+void StopHashTrace();
+uint64_t GetHashTraceBytes();
+
+/** Capture hooks, called only while fHashTrace is set */
+void TraceLatticePOW(const LatticeRoundTable& table, const void* data, size_t len, const uint256& result);
+void TraceLatticeHash256(const unsigned char* data, size_t len, const unsigned char* hash);
+void TraceHash160(const unsigned char* data, size_t len, const uint160& result);
+void TraceSipHash(uint64_t k0, uint64_t k1, const uint256& val, const uint32_t* extra, uint64_t result);
+void TraceMurmurHash3(unsigned int nHashSeed, const std::vector<unsigned char>& vData, unsigned int result);
+
+/** Hash calls made inside this scope belong to an outer traced call and are not recorded */
+class CHashTraceNested
+{
+public:
+    CHashTraceNested();
+    ~CHashTraceNested();
+};
+
+/** One record of a loaded trace; nPowVersion and hashPrevBlock are set for LATTICE_POW */
+struct HashTraceRecord {
+    HashTraceType type;
+    uint64_t nOffset;               // Payload position in HashTraceFile::vData
+    uint32_t nLength;
+    uint64_t nCheck;
+    int nPowVersion;
+    uint256 hashPrevBlock;
+};
+
+struct HashTraceFile {
+    std::vector<unsigned char> vData;
+    std::vector<HashTraceRecord> vRecords;
+    bool fMatrixSeed;               // The capturing process had initialized the v1/v2 matrix
+    uint256 matrixSeed;
+};
+
+/** Load a whole trace into memory; fails on a bad header or a truncated or malformed chunk */
+bool ReadHashTrace(const std::string& strPath, HashTraceFile& trace, std::string& strError);
+
+#endif // LATTICE_HASHTRACE_H
@@ -0,0 +1,341 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "latticemetrics.h"
+
+#include "util.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+CLatticeMetrics g_lattice_metrics;
+
+static std::atomic<int> nNextMetricSlot(0);
+
+int GetMetricThreadSlot()
+{
+    static thread_local int nSlot = -1;
+    if (nSlot < 0)
+        nSlot = nNextMetricSlot++ % MAX_METRIC_THREADS;
+    return nSlot;
+}
+
+uint64_t CMetricCounter::Get() const
+{
+    uint64_t nTotal = 0;
+    for (const Slot& slot : slots) {
+        nTotal += slot.n.load(std::memory_order_relaxed);
+    }
+    return nTotal;
+}
+
+void CMetricHistogram::Observe(int64_t nNanos)
+{
+    if (nNanos < 0)
+        nNanos = 0;
+    // Bucket i holds observations up to 2^i microseconds
+    uint64_t nMicros = (nNanos + 999) / 1000;
+    int nBucket = 0;
+    while (nBucket < METRIC_HISTOGRAM_BUCKETS && nMicros > (1ULL << nBucket))
+        nBucket++;
+
+    Stripe& stripe = stripes[GetMetricThreadSlot() % METRIC_HISTOGRAM_STRIPES];
+    stripe.buckets[nBucket].fetch_add(1, std::memory_order_relaxed);
+    stripe.nSumNanos.fetch_add(nNanos, std::memory_order_relaxed);
+}
+
+void CMetricHistogram::Snapshot(std::vector<uint64_t>& vBuckets, double& nSumSeconds, uint64_t& nCount) const
+{
+    vBuckets.assign(METRIC_HISTOGRAM_BUCKETS + 1, 0);
+    uint64_t nSumNanos = 0;
+    for (const Stripe& stripe : stripes) {
+        for (int i = 0; i <= METRIC_HISTOGRAM_BUCKETS; i++) {
+            vBuckets[i] += stripe.buckets[i].load(std::memory_order_relaxed);
+        }
+        nSumNanos += stripe.nSumNanos.load(std::memory_order_relaxed);
+    }
+    for (int i = 1; i <= METRIC_HISTOGRAM_BUCKETS; i++) {
+        vBuckets[i] += vBuckets[i - 1];
+    }
+    nCount = vBuckets[METRIC_HISTOGRAM_BUCKETS];
+    nSumSeconds = nSumNanos / 1e9;
+}
+
+struct MetricGauge {
+    std::string help;
+    std::function<double()> fn;
+    std::function<uint64_t()> fnCounter;    // Set instead of fn for counters
+};
+
+// Registration and scraping only; never touched on the hot path
+static std::mutex cs_metrics;
+static std::map<std::string, std::unique_ptr<CMetricHistogram>> mapStageHistograms;
+
+// Held while gauges are called, without cs_metrics, so a gauge taking its
+// owner's lock cannot deadlock against that owner looking up a histogram
+static std::mutex cs_gauges;
+static std::map<std::string, MetricGauge> mapGauges;
+
+CMetricHistogram& GetStageHistogram(const std::string& stage)
+{
+    std::lock_guard<std::mutex> lock(cs_metrics);
+    std::unique_ptr<CMetricHistogram>& histogram = mapStageHistograms[stage];
+    if (!histogram)
+        histogram.reset(new CMetricHistogram());
+    return *histogram;
+}
+
+void RegisterMetricGauge(const std::string& name, const std::string& help, std::function<double()> fn)
+{
+    std::lock_guard<std::mutex> lock(cs_gauges);
+    mapGauges[name] = MetricGauge{help, std::move(fn), nullptr};
+}
+
+void UnregisterMetricGauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(cs_gauges);
+    mapGauges.erase(name);
+}
+
+void RegisterMetricCounter(const std::string& name, const std::string& help, std::function<uint64_t()> fn)
+{
+    std::lock_guard<std::mutex> lock(cs_gauges);
+    mapGauges[name] = MetricGauge{help, nullptr, std::move(fn)};
+}
+
+void UnregisterMetricCounter(const std::string& name)
+{
+    UnregisterMetricGauge(name);
+}
+
+static void RenderHeader(std::string& out, const std::string& name, const char* type, const std::string& help)
+{
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+static void RenderCounter(std::string& out, const std::string& name, const std::string& help, const CMetricCounter& counter)
+{
+    RenderHeader(out, name, "counter", help);
+    out += strprintf("%s %u\n", name, counter.Get());
+}
+
+static void RenderHistogram(std::string& out, const std::string& name, const std::string& labels, const CMetricHistogram& histogram)
+{
+    std::vector<uint64_t> vBuckets;
+    double nSum;
+    uint64_t nCount;
+    histogram.Snapshot(vBuckets, nSum, nCount);
+
+    std::string sep = labels.empty() ? "" : ",";
+    for (int i = 0; i < METRIC_HISTOGRAM_BUCKETS; i++) {
+        out += strprintf("%s_bucket{%s%sle=\"%.9g\"} %u\n", name, labels, sep, (double)(1ULL << i) / 1e6, vBuckets[i]);
+    }
+    out += strprintf("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, labels, sep, nCount);
+    std::string suffix = labels.empty() ? "" : "{" + labels + "}";
+    out += strprintf("%s_sum%s %.9f\n", name, suffix, nSum);
+    out += strprintf("%s_count%s %u\n", name, suffix, nCount);
+}
+
+/** Hash counts at the previous scrape, for the instantaneous rate gauges */
+static int64_t nLastRateNanos = 0;
+static uint64_t vLastThreadHashes[MAX_METRIC_THREADS];
+
+std::string RenderLatticeMetrics()
+{
+    std::unique_lock<std::mutex> lock(cs_metrics);
+    std::string out;
+    const CLatticeMetrics& m = g_lattice_metrics;
+
+    RenderHeader(out, "lattice_hashes_total", "counter", "HashLatticePOW evaluations by thread slot");
+    uint64_t vThreadHashes[MAX_METRIC_THREADS];
+    for (int i = 0; i < MAX_METRIC_THREADS; i++) {
+        vThreadHashes[i] = m.hashes.GetThread(i);
+        if (vThreadHashes[i] > 0)
+            out += strprintf("lattice_hashes_total{thread=\"%d\"} %u\n", i, vThreadHashes[i]);
+    }
+
+    // Rates since the previous scrape; zero on the first one
+    int64_t nNow = MetricNanos();
+    double nInterval = nLastRateNanos > 0 ? (nNow - nLastRateNanos) / 1e9 : 0;
+    double nTotalRate = 0;
+    RenderHeader(out, "lattice_hashrate", "gauge", "Hashes per second by thread slot since the previous scrape");
+    for (int i = 0; i < MAX_METRIC_THREADS; i++) {
+        if (vThreadHashes[i] == 0)
+            continue;
+        double nRate = nInterval > 0 ? (vThreadHashes[i] - vLastThreadHashes[i]) / nInterval : 0;
+        nTotalRate += nRate;
+        out += strprintf("lattice_hashrate{thread=\"%d\"} %.1f\n", i, nRate);
+        vLastThreadHashes[i] = vThreadHashes[i];
+    }
+    nLastRateNanos = nNow;
+    RenderHeader(out, "lattice_hashrate_total", "gauge", "Hashes per second over all threads since the previous scrape");
+    out += strprintf("lattice_hashrate_total %.1f\n", nTotalRate);
+
+    RenderHeader(out, "lattice_hash_seconds", "histogram", "Latency of one HashLatticePOW evaluation");
+    RenderHistogram(out, "lattice_hash_seconds", "", m.hashLatency);
+    RenderHeader(out, "lattice_verify_seconds", "histogram", "Latency of share and block PoW verification");
+    RenderHistogram(out, "lattice_verify_seconds", "", m.verifyLatency);
+
+    if (!mapStageHistograms.empty()) {
+        RenderHeader(out, "lattice_stage_seconds", "histogram", "Time spent per item in each pipeline stage");
+        for (const auto& entry : mapStageHistograms) {
+            RenderHistogram(out, "lattice_stage_seconds", "stage=\"" + entry.first + "\"", *entry.second);
+        }
+    }
+
+    RenderCounter(out, "lattice_matrix_cache_hits_total", "Lattice matrix lookups served without expansion", m.matrixCacheHits);
+    RenderCounter(out, "lattice_matrix_cache_misses_total", "Lattice matrix expansions", m.matrixCacheMisses);
+    RenderCounter(out, "lattice_shares_accepted_total", "Shares accepted", m.sharesAccepted);
+    RenderCounter(out, "lattice_shares_rejected_total", "Shares rejected, including stale ones", m.sharesRejected);
+    RenderCounter(out, "lattice_stale_work_total", "Shares or blocks submitted for superseded work", m.staleWork);
+
+    lock.unlock();
+
+    std::lock_guard<std::mutex> lockGauges(cs_gauges);
+    for (const auto& entry : mapGauges) {
+        if (entry.second.fnCounter) {
+            RenderHeader(out, entry.first, "counter", entry.second.help);
+            out += strprintf("%s %u\n", entry.first, entry.second.fnCounter());
+        } else {
+            RenderHeader(out, entry.first, "gauge", entry.second.help);
+            out += strprintf("%s %g\n", entry.first, entry.second.fn());
+        }
+    }
+    return out;
+}
+
+CMetricsServer::CMetricsServer() : hListenSocket(INVALID_SOCKET), nListenPort(0), fInterrupt(false)
+{
+    wakeupPipe[0] = wakeupPipe[1] = -1;
+}
+
+CMetricsServer::~CMetricsServer()
+{
+    Stop();
+}
+
+bool CMetricsServer::Start(uint16_t nPort)
+{
+    hListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (hListenSocket == INVALID_SOCKET) {
+        LogPrintf("Metrics: socket() failed: %d\n", WSAGetLastError());
+        return false;
+    }
+
+    int nOne = 1;
+    setsockopt(hListenSocket, SOL_SOCKET, SO_REUSEADDR, (void*)&nOne, sizeof(int));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(nPort);
+    if (bind(hListenSocket, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(hListenSocket, SOMAXCONN) == SOCKET_ERROR) {
+        LogPrintf("Metrics: unable to listen on port %u: %d\n", nPort, WSAGetLastError());
+        CloseSocket(hListenSocket);
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(hListenSocket, (struct sockaddr*)&addr, &len);
+    nListenPort = ntohs(addr.sin_port);
+
+    if (pipe(wakeupPipe) != 0) {
+        CloseSocket(hListenSocket);
+        return false;
+    }
+
+    fInterrupt = false;
+    threadHTTP = std::thread(&CMetricsServer::ThreadHTTP, this);
+    LogPrintf("Metrics: serving http://127.0.0.1:%u/metrics\n", nListenPort);
+    return true;
+}
+
+void CMetricsServer::Stop()
+{
+    if (!threadHTTP.joinable())
+        return;
+
+    fInterrupt = true;
+    char c = 0;
+    if (write(wakeupPipe[1], &c, 1) != 1) {
+        LogPrintf("Metrics: failed to wake HTTP thread\n");
+    }
+    threadHTTP.join();
+
+    close(wakeupPipe[0]);
+    close(wakeupPipe[1]);
+    wakeupPipe[0] = wakeupPipe[1] = -1;
+    CloseSocket(hListenSocket);
+}
+
+void CMetricsServer::ThreadHTTP()
+{
+    RenameThread("lattice-metrics");
+
+    while (!fInterrupt) {
+        struct pollfd pfd[2];
+        pfd[0].fd = wakeupPipe[0];
+        pfd[0].events = POLLIN;
+        pfd[1].fd = hListenSocket;
+        pfd[1].events = POLLIN;
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            LogPrintf("Metrics: poll() failed: %d\n", WSAGetLastError());
+            break;
+        }
+        if (fInterrupt)
+            break;
+        if (pfd[1].revents & POLLIN) {
+            SOCKET hSocket = accept(hListenSocket, nullptr, nullptr);
+            if (hSocket != INVALID_SOCKET) {
+                HandleConnection(hSocket);
+                CloseSocket(hSocket);
+            }
+        }
+    }
+}
+
+void CMetricsServer::HandleConnection(SOCKET hSocket)
+{
+    // Scrapers send one small request per connection; read just the headers
+    std::string request;
+    struct pollfd pfd;
+    pfd.fd = hSocket;
+    pfd.events = POLLIN;
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        if (poll(&pfd, 1, 1000) <= 0)
+            return;
+        char buf[1024];
+        ssize_t n = recv(hSocket, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return;
+        request.append(buf, n);
+    }
+
+    std::string status = "200 OK", body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0) {
+        body = RenderLatticeMetrics();
+    } else {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+
+    std::string response = strprintf("HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                     "Content-Length: %u\r\nConnection: close\r\n\r\n", status, body.size());
+    response += body;
+    size_t nSent = 0;
+    while (nSent < response.size()) {
+        ssize_t n = send(hSocket, response.data() + nSent, response.size() - nSent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            return;
+        }
+        nSent += n;
+    }
+}
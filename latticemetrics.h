@@ -0,0 +1,140 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_LATTICEMETRICS_H
+#define LATTICE_LATTICEMETRICS_H
+
+#include "compat.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint16_t DEFAULT_METRICS_PORT = 9342;
+/** Per-thread slots in striped metrics; threads beyond this share slots */
+static const int MAX_METRIC_THREADS = 128;
+/** Stripes in a histogram; threads pick one by their slot */
+static const int METRIC_HISTOGRAM_STRIPES = 16;
+/** Histogram buckets: le 1us, 2us, 4us ... 2^(N-1)us, then +Inf */
+static const int METRIC_HISTOGRAM_BUCKETS = 22;
+
+/** Index of the calling thread's slot, assigned on first use */
+int GetMetricThreadSlot();
+
+inline int64_t MetricNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Monotonic counter striped across per-thread cache lines, so hot-path
+ * increments are a relaxed add on memory no other thread writes.
+ */
+class CMetricCounter
+{
+public:
+    void Add(uint64_t n = 1) { slots[GetMetricThreadSlot()].n.fetch_add(n, std::memory_order_relaxed); }
+
+    uint64_t Get() const;
+    uint64_t GetThread(int nSlot) const { return slots[nSlot].n.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> n;
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    };
+    Slot slots[MAX_METRIC_THREADS];
+};
+
+/** Latency histogram with power-of-two microsecond buckets */
+class CMetricHistogram
+{
+public:
+    void Observe(int64_t nNanos);
+
+    /** Cumulative bucket counts (Prometheus "le" semantics), sum and count */
+    void Snapshot(std::vector<uint64_t>& vBuckets, double& nSumSeconds, uint64_t& nCount) const;
+
+private:
+    struct Stripe {
+        std::atomic<uint64_t> buckets[METRIC_HISTOGRAM_BUCKETS + 1];
+        std::atomic<uint64_t> nSumNanos;
+        char padding[64];
+    };
+    Stripe stripes[METRIC_HISTOGRAM_STRIPES];
+};
+
+/** Times a scope into a histogram */
+class CMetricTimer
+{
+public:
+    explicit CMetricTimer(CMetricHistogram& histogramIn) : histogram(histogramIn), nStart(MetricNanos()) {}
+    ~CMetricTimer() { histogram.Observe(MetricNanos() - nStart); }
+
+private:
+    CMetricHistogram& histogram;
+    const int64_t nStart;
+};
+
+/** Fixed LATTICE-PoW metrics updated from the miner and verifier hot paths */
+struct CLatticeMetrics {
+    CMetricCounter hashes;              // HashLatticePOW evaluations, per thread
+    CMetricHistogram hashLatency;       // One HashLatticePOW evaluation
+    CMetricCounter matrixCacheHits;     // Lattice matrix reused instead of expanded
+    CMetricCounter matrixCacheMisses;
+    CMetricCounter sharesAccepted;
+    CMetricCounter sharesRejected;
+    CMetricCounter staleWork;           // Shares or blocks for superseded work
+    CMetricHistogram verifyLatency;     // Share/block verification, end to end
+};
+
+extern CLatticeMetrics g_lattice_metrics;
+
+/**
+ * Named per-stage timing histogram, created on first use. Look it up once
+ * and keep the reference; the lookup itself takes a lock.
+ */
+CMetricHistogram& GetStageHistogram(const std::string& stage);
+
+/**
+ * Gauge sampled when metrics are scraped, e.g. a queue depth. fn runs on the
+ * scraping thread; once UnregisterMetricGauge returns it is no longer running
+ * or called, so do not unregister while holding a lock fn takes.
+ */
+void RegisterMetricGauge(const std::string& name, const std::string& help, std::function<double()> fn);
+void UnregisterMetricGauge(const std::string& name);
+/** Counter a component keeps itself, sampled like a gauge; name should end in _total */
+void RegisterMetricCounter(const std::string& name, const std::string& help, std::function<uint64_t()> fn);
+void UnregisterMetricCounter(const std::string& name);
+
+/** Render all metrics in the Prometheus text exposition format */
+std::string RenderLatticeMetrics();
+
+/** Minimal HTTP server answering GET /metrics on the loopback interface */
+class CMetricsServer
+{
+public:
+    CMetricsServer();
+    ~CMetricsServer();
+
+    bool Start(uint16_t nPort = DEFAULT_METRICS_PORT);
+    void Stop();
+    uint16_t GetPort() const { return nListenPort; }
+
+private:
+    SOCKET hListenSocket;
+    int wakeupPipe[2];
+    uint16_t nListenPort;
+    std::thread threadHTTP;
+    std::atomic<bool> fInterrupt;
+
+    void ThreadHTTP();
+    void HandleConnection(SOCKET hSocket);
+};
+
+#endif // LATTICE_LATTICEMETRICS_H
@@ -0,0 +1,307 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "latticeplacement.h"
+
+#include "util.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static const char* const PLACEMENT_POLICY_NAMES[] = {"none", "core", "smt", "numa"};
+
+static std::mutex cs_placement;
+static PlacementPolicy placementPolicy = DEFAULT_PLACEMENT_POLICY;
+static std::vector<PlacementSlot> vPlacementSlots;
+static std::vector<int> vSlotUsers;
+/** Bumped by SetWorkerPlacement so workers from an old plan do not release new slots */
+static uint64_t nPlacementGeneration = 0;
+
+/** Parse a sysfs CPU list such as "0-3,8,10-11" */
+static bool ParseCpuList(const std::string& str, std::set<int>& setCpus)
+{
+    size_t nPos = 0;
+    while (nPos < str.size() && str[nPos] != '\n') {
+        size_t nEnd = str.find_first_of(",\n", nPos);
+        if (nEnd == std::string::npos)
+            nEnd = str.size();
+        std::string strRange = str.substr(nPos, nEnd - nPos);
+        size_t nDash = strRange.find('-');
+        char* pEnd;
+        long nFirst = strtol(strRange.c_str(), &pEnd, 10);
+        long nLast = nDash == std::string::npos ? nFirst : strtol(strRange.c_str() + nDash + 1, &pEnd, 10);
+        if (strRange.empty() || nFirst < 0 || nLast < nFirst || nLast > 0xFFFF)
+            return false;
+        for (long n = nFirst; n <= nLast; n++) {
+            setCpus.insert(n);
+        }
+        nPos = nEnd < str.size() && str[nEnd] == ',' ? nEnd + 1 : nEnd;
+    }
+    return true;
+}
+
+static bool ReadSysFile(const std::string& strPath, std::string& str)
+{
+    std::ifstream file(strPath);
+    if (!file)
+        return false;
+    std::getline(file, str);
+    return true;
+}
+
+static int ReadSysInt(const std::string& strPath, int nDefault)
+{
+    std::string str;
+    if (!ReadSysFile(strPath, str) || str.empty())
+        return nDefault;
+    return atoi(str.c_str());
+}
+
+#ifdef __linux__
+bool ReadCpuTopology(CpuTopology& topology, const std::string& strSysRoot)
+{
+    topology.vCpus.clear();
+    topology.nPhysicalCores = 0;
+    topology.nNodes = 0;
+
+    std::string strOnline;
+    std::set<int> setOnline;
+    if (!ReadSysFile(strSysRoot + "/devices/system/cpu/online", strOnline) || !ParseCpuList(strOnline, setOnline))
+        return false;
+
+    std::map<int, int> mapCpuNode;
+    std::set<int> setNodes;
+    DIR* dir = opendir((strSysRoot + "/devices/system/node").c_str());
+    if (dir != nullptr) {
+        while (struct dirent* entry = readdir(dir)) {
+            std::string strName = entry->d_name;
+            if (strName.compare(0, 4, "node") != 0 || strName.size() < 5 || !isdigit(strName[4]))
+                continue;
+            int nNode = atoi(strName.c_str() + 4);
+            std::string strCpus;
+            std::set<int> setCpus;
+            if (!ReadSysFile(strSysRoot + "/devices/system/node/" + strName + "/cpulist", strCpus) || !ParseCpuList(strCpus, setCpus))
+                continue;
+            for (int nCpu : setCpus) {
+                mapCpuNode[nCpu] = nNode;
+            }
+            if (!setCpus.empty())
+                setNodes.insert(nNode);
+        }
+        closedir(dir);
+    }
+
+    cpu_set_t mask;
+    bool fMask = sched_getaffinity(0, sizeof(mask), &mask) == 0;
+
+    std::set<std::pair<int, int>> setCores;
+    for (int nCpu : setOnline) {
+        if (fMask && (nCpu >= CPU_SETSIZE || !CPU_ISSET(nCpu, &mask)))
+            continue;
+        std::string strTopology = strprintf("%s/devices/system/cpu/cpu%d/topology/", strSysRoot, nCpu);
+        CpuInfo cpu;
+        cpu.nCpu = nCpu;
+        cpu.nPackage = ReadSysInt(strTopology + "physical_package_id", 0);
+        cpu.nCore = ReadSysInt(strTopology + "core_id", nCpu);
+        cpu.nNode = mapCpuNode.count(nCpu) ? mapCpuNode[nCpu] : 0;
+        topology.vCpus.push_back(cpu);
+        setCores.insert(std::make_pair(cpu.nPackage, cpu.nCore));
+    }
+    topology.nPhysicalCores = setCores.size();
+    topology.nNodes = std::max<int>(setNodes.size(), 1);
+    return !topology.vCpus.empty();
+}
+#else
+bool ReadCpuTopology(CpuTopology& topology, const std::string& /*strSysRoot*/)
+{
+    topology.vCpus.clear();
+    topology.nPhysicalCores = 0;
+    topology.nNodes = 0;
+    return false;
+}
+#endif
+
+std::string FormatCpuTopology(const CpuTopology& topology)
+{
+    std::set<int> setPackages;
+    for (const CpuInfo& cpu : topology.vCpus) {
+        setPackages.insert(cpu.nPackage);
+    }
+    return strprintf("%u logical CPUs, %d physical cores, %u packages, %d NUMA nodes",
+                     topology.vCpus.size(), topology.nPhysicalCores, setPackages.size(), topology.nNodes);
+}
+
+std::vector<PlacementSlot> PlanPlacement(const CpuTopology& topology, PlacementPolicy policy)
+{
+    std::vector<PlacementSlot> vSlots;
+    if (policy == PLACEMENT_NONE)
+        return vSlots;
+
+    // Node -> (package, core) -> logical CPUs, all ordered
+    std::map<int, std::map<std::pair<int, int>, std::vector<int>>> mapNodes;
+    for (const CpuInfo& cpu : topology.vCpus) {
+        mapNodes[cpu.nNode][std::make_pair(cpu.nPackage, cpu.nCore)].push_back(cpu.nCpu);
+    }
+
+    if (policy == PLACEMENT_NUMA) {
+        for (const auto& node : mapNodes) {
+            PlacementSlot slot;
+            slot.nNode = node.first;
+            for (const auto& core : node.second) {
+                slot.vCpus.insert(slot.vCpus.end(), core.second.begin(), core.second.end());
+            }
+            std::sort(slot.vCpus.begin(), slot.vCpus.end());
+            vSlots.push_back(slot);
+        }
+        return vSlots;
+    }
+
+    // Take cores from each node in turn so a partial thread count still
+    // uses every socket's caches and memory controller
+    std::vector<std::vector<const std::vector<int>*>> vNodeCores;
+    for (const auto& node : mapNodes) {
+        vNodeCores.emplace_back();
+        for (const auto& core : node.second) {
+            vNodeCores.back().push_back(&core.second);
+        }
+    }
+    std::vector<int> vNodeIds;
+    for (const auto& node : mapNodes) {
+        vNodeIds.push_back(node.first);
+    }
+    for (size_t i = 0; ; i++) {
+        bool fAny = false;
+        for (size_t n = 0; n < vNodeCores.size(); n++) {
+            if (i >= vNodeCores[n].size())
+                continue;
+            fAny = true;
+            const std::vector<int>& vSiblings = *vNodeCores[n][i];
+            size_t nThreads = policy == PLACEMENT_SMT ? vSiblings.size() : 1;
+            for (size_t t = 0; t < nThreads; t++) {
+                PlacementSlot slot;
+                slot.nNode = vNodeIds[n];
+                slot.vCpus.push_back(vSiblings[t]);
+                vSlots.push_back(slot);
+            }
+        }
+        if (!fAny)
+            break;
+    }
+    return vSlots;
+}
+
+bool ParsePlacementPolicy(const std::string& str, PlacementPolicy& policy)
+{
+    for (int i = PLACEMENT_NONE; i <= PLACEMENT_NUMA; i++) {
+        if (str == PLACEMENT_POLICY_NAMES[i]) {
+            policy = (PlacementPolicy)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* GetPlacementPolicyName(PlacementPolicy policy)
+{
+    return PLACEMENT_POLICY_NAMES[policy];
+}
+
+bool SetWorkerPlacement(PlacementPolicy policy)
+{
+    CpuTopology topology;
+    std::vector<PlacementSlot> vSlots;
+    bool fOk = true;
+    if (policy != PLACEMENT_NONE) {
+        if (!ReadCpuTopology(topology)) {
+            LogPrintf("Worker placement: cannot read CPU topology, threads stay unpinned\n");
+            policy = PLACEMENT_NONE;
+            fOk = false;
+        } else {
+            vSlots = PlanPlacement(topology, policy);
+            LogPrintf("Worker placement: %s, %s, %u worker slots\n", GetPlacementPolicyName(policy),
+                      FormatCpuTopology(topology), vSlots.size());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(cs_placement);
+    placementPolicy = policy;
+    vPlacementSlots = vSlots;
+    vSlotUsers.assign(vSlots.size(), 0);
+    nPlacementGeneration++;
+    return fOk;
+}
+
+PlacementPolicy GetWorkerPlacement()
+{
+    std::lock_guard<std::mutex> lock(cs_placement);
+    return placementPolicy;
+}
+
+CWorkerPlacement::CWorkerPlacement() : nSlot(-1), nNode(-1), nGeneration(0)
+{
+    {
+        std::lock_guard<std::mutex> lock(cs_placement);
+        if (vPlacementSlots.empty())
+            return;
+        nSlot = std::min_element(vSlotUsers.begin(), vSlotUsers.end()) - vSlotUsers.begin();
+        vSlotUsers[nSlot]++;
+        nGeneration = nPlacementGeneration;
+        nNode = vPlacementSlots[nSlot].nNode;
+        vCpus = vPlacementSlots[nSlot].vCpus;
+    }
+
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (int nCpu : vCpus) {
+        if (nCpu < CPU_SETSIZE)
+            CPU_SET(nCpu, &mask);
+    }
+    int nErr = pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask);
+    if (nErr != 0)
+        LogPrintf("Worker placement: pinning to %s failed (%s)\n", ToString(), strerror(nErr));
+#endif
+}
+
+CWorkerPlacement::~CWorkerPlacement()
+{
+    if (nSlot < 0)
+        return;
+    std::lock_guard<std::mutex> lock(cs_placement);
+    if (nGeneration == nPlacementGeneration)
+        vSlotUsers[nSlot]--;
+}
+
+std::string CWorkerPlacement::ToString() const
+{
+    if (nSlot < 0)
+        return "unpinned";
+    std::string strCpus;
+    for (int nCpu : vCpus) {
+        strCpus += strprintf("%s%d", strCpus.empty() ? "" : ",", nCpu);
+    }
+    return strprintf("cpu %s node %d", strCpus, nNode);
+}
+
+void CWorkerPlacement::LocalizeRoundTable(LatticeRoundTable& table)
+{
+    if (nSlot < 0 || table.matrix == nullptr || table.matrix == localMatrix.get())
+        return;
+    if (!localMatrix)
+        localMatrix.reset(new LatticeMatrix());
+    *localMatrix = *table.matrix;
+    table.matrix = localMatrix.get();
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_LATTICEPLACEMENT_H
+#define LATTICE_LATTICEPLACEMENT_H
+
+#include "hash.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/** How hashing worker threads are spread over the CPUs */
+enum PlacementPolicy {
+    PLACEMENT_NONE,     // Leave threads to the scheduler
+    PLACEMENT_CORE,     // One thread per physical core, SMT siblings idle
+    PLACEMENT_SMT,      // Fill both siblings of a core before the next one
+    PLACEMENT_NUMA,     // One pool per NUMA node; threads float inside it
+};
+
+static const PlacementPolicy DEFAULT_PLACEMENT_POLICY = PLACEMENT_NONE;
+
+struct CpuInfo {
+    int nCpu;           // Logical CPU number
+    int nPackage;       // physical_package_id
+    int nCore;          // core_id, unique only within a package
+    int nNode;          // NUMA node, 0 without NUMA
+};
+
+struct CpuTopology {
+    std::vector<CpuInfo> vCpus;     // Online CPUs this process may run on
+    int nPhysicalCores;
+    int nNodes;
+};
+
+/** A set of CPUs one worker is pinned to */
+struct PlacementSlot {
+    std::vector<int> vCpus;
+    int nNode;
+};
+
+/**
+ * Read online CPUs, their package, core and NUMA node from strSysRoot
+ * (normally /sys), restricted to the process' affinity mask so cpusets and
+ * taskset are honoured.
+ */
+bool ReadCpuTopology(CpuTopology& topology, const std::string& strSysRoot = "/sys");
+std::string FormatCpuTopology(const CpuTopology& topology);
+
+/** Worker slots in the order they are handed out; cores alternate between nodes */
+std::vector<PlacementSlot> PlanPlacement(const CpuTopology& topology, PlacementPolicy policy);
+
+bool ParsePlacementPolicy(const std::string& str, PlacementPolicy& policy);
+const char* GetPlacementPolicyName(PlacementPolicy policy);
+
+/**
+ * Set the policy for workers started from now on: mining, Stratum
+ * validation, PoW verification and reindex hashing threads. Falls back to
+ * PLACEMENT_NONE if the topology cannot be read.
+ */
+bool SetWorkerPlacement(PlacementPolicy policy);
+PlacementPolicy GetWorkerPlacement();
+
+/**
+ * Pins the calling thread to the least used slot of the current plan for
+ * the rest of its life and releases the slot on destruction. Create it
+ * first thing in a worker, before its scratch is allocated: Linux places
+ * pages on the node of the CPU that first touches them.
+ */
+class CWorkerPlacement
+{
+public:
+    CWorkerPlacement();
+    ~CWorkerPlacement();
+
+    bool IsPinned() const { return nSlot >= 0; }
+    int GetNode() const { return nNode; }
+    std::string ToString() const;
+
+    /**
+     * Point table at this worker's own copy of its matrix, allocated after
+     * pinning so it lives on the local node instead of wherever the shared
+     * one was first touched. No-op when not pinned.
+     */
+    void LocalizeRoundTable(LatticeRoundTable& table);
+
+private:
+    int nSlot;
+    int nNode;
+    uint64_t nGeneration;
+    std::vector<int> vCpus;
+    std::unique_ptr<LatticeMatrix> localMatrix;
+};
+
+#endif // LATTICE_LATTICEPLACEMENT_H
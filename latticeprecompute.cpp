@@ -0,0 +1,216 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "latticeprecompute.h"
+
+#include "crypto/sha3.h"
+#include "latticemetrics.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+
+const uint64_t* LatticeTipState::GetMidstate(const unsigned char* header) const
+{
+    if (!fPrefix || memcmp(header, prefix, LATTICE_HEADER_PREFIX_SIZE) != 0)
+        return nullptr;
+    return midstate;
+}
+
+CLatticePrecomputer::CLatticePrecomputer(size_t nMaxTipsIn) :
+    nMaxTips(std::max<size_t>(nMaxTipsIn, 1)), fInterrupt(false), nHits(0), nWaits(0), nMisses(0), nLastBuildMicros(0)
+{
+    RegisterMetricCounter("lattice_precompute_hits_total", "Tip switches served from a precomputed round table",
+                          [this] { return nHits.load(); });
+    RegisterMetricCounter("lattice_precompute_misses_total", "Tip switches that built their round table on demand",
+                          [this] { return nMisses.load(); });
+    RegisterMetricGauge("lattice_precompute_last_build_micros", "Time the last tip round table took to build",
+                        [this] { return (double)nLastBuildMicros.load(); });
+}
+
+CLatticePrecomputer::~CLatticePrecomputer()
+{
+    Stop();
+    UnregisterMetricCounter("lattice_precompute_hits_total");
+    UnregisterMetricCounter("lattice_precompute_misses_total");
+    UnregisterMetricGauge("lattice_precompute_last_build_micros");
+}
+
+void CLatticePrecomputer::Start()
+{
+    if (threadBuild.joinable())
+        return;
+    fInterrupt = false;
+    threadBuild = std::thread(&CLatticePrecomputer::ThreadBuild, this);
+}
+
+void CLatticePrecomputer::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fInterrupt = true;
+    }
+    cond.notify_all();
+    if (threadBuild.joinable())
+        threadBuild.join();
+}
+
+std::deque<CLatticePrecomputer::Entry>::iterator CLatticePrecomputer::Find(const uint256& hashTip, int nPoWVersion)
+{
+    return std::find_if(entries.begin(), entries.end(), [&](const Entry& entry) {
+        return entry.hashTip == hashTip && entry.nPoWVersion == nPoWVersion;
+    });
+}
+
+std::deque<CLatticePrecomputer::Entry>::iterator CLatticePrecomputer::Touch(const uint256& hashTip, int nPoWVersion)
+{
+    auto it = Find(hashTip, nPoWVersion);
+    if (it == entries.end() || it == entries.end() - 1)
+        return it;
+    Entry entry = std::move(*it);
+    entries.erase(it);
+    entries.push_back(std::move(entry));
+    return entries.end() - 1;
+}
+
+void CLatticePrecomputer::Trim()
+{
+    for (auto it = entries.begin(); entries.size() > nMaxTips && it != entries.end();) {
+        if (it->fBuilding) {
+            ++it;
+        } else {
+            it = entries.erase(it);
+        }
+    }
+}
+
+void CLatticePrecomputer::BuildTable(const uint256& hashTip, int nPoWVersion, LatticeRoundTable& table)
+{
+    int64_t nStart = MetricNanos();
+    BuildLatticeRoundTable(hashTip, nPoWVersion, table);
+    nLastBuildMicros = (MetricNanos() - nStart) / 1000;
+}
+
+void CLatticePrecomputer::Store(const uint256& hashTip, int nPoWVersion, const LatticeRoundTable& table)
+{
+    auto it = Find(hashTip, nPoWVersion);
+    if (it == entries.end())
+        return;
+    it->state.table = table;
+    it->fReady = true;
+    it->fBuilding = false;
+}
+
+void CLatticePrecomputer::AddCandidate(const uint256& hashTip, int nPoWVersion, const unsigned char* headerPrefix)
+{
+    if (nPoWVersion < LATTICE_POW_VERSION_XOF)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        auto it = Touch(hashTip, nPoWVersion);
+        if (it == entries.end()) {
+            entries.emplace_back();
+            it = entries.end() - 1;
+            it->hashTip = hashTip;
+            it->nPoWVersion = nPoWVersion;
+            it->fBuilding = false;
+            it->fReady = false;
+            it->state.fPrefix = false;
+        }
+        if (headerPrefix) {
+            // One permutation; cheaper than handing it to the build thread
+            memcpy(it->state.prefix, headerPrefix, LATTICE_HEADER_PREFIX_SIZE);
+            Keccak512_80Prefix(it->state.prefix, it->state.midstate);
+            it->state.fPrefix = true;
+        }
+        Trim();
+    }
+    cond.notify_all();
+}
+
+void CLatticePrecomputer::GetTip(const uint256& hashTip, int nPoWVersion, LatticeTipState& tip)
+{
+    if (nPoWVersion < LATTICE_POW_VERSION_XOF) {
+        tip.fPrefix = false;
+        BuildLatticeRoundTable(hashTip, nPoWVersion, tip.table);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(cs);
+    bool fWaited = false;
+    while (true) {
+        auto it = Touch(hashTip, nPoWVersion);
+        if (it != entries.end() && it->fReady) {
+            if (fWaited) {
+                nWaits++;
+            } else {
+                nHits++;
+            }
+            tip = it->state;
+            return;
+        }
+        if (it != entries.end() && it->fBuilding) {
+            fWaited = true;
+            cond.wait(lock);
+            continue;
+        }
+        if (it == entries.end()) {
+            entries.emplace_back();
+            it = entries.end() - 1;
+            it->hashTip = hashTip;
+            it->nPoWVersion = nPoWVersion;
+            it->fReady = false;
+            it->state.fPrefix = false;
+        }
+        // Claim it so neither the build thread nor another caller builds it too
+        it->fBuilding = true;
+        tip = it->state;
+        Trim();
+        break;
+    }
+
+    nMisses++;
+    lock.unlock();
+    BuildTable(hashTip, nPoWVersion, tip.table);
+    lock.lock();
+    Store(hashTip, nPoWVersion, tip.table);
+    lock.unlock();
+    cond.notify_all();
+}
+
+size_t CLatticePrecomputer::GetQueueDepth()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return std::count_if(entries.begin(), entries.end(), [](const Entry& entry) {
+        return !entry.fReady && !entry.fBuilding;
+    });
+}
+
+void CLatticePrecomputer::ThreadBuild()
+{
+    RenameThread("lattice-precompute");
+    std::unique_lock<std::mutex> lock(cs);
+    while (true) {
+        // Newest candidate first: it is the one a switch is most likely to need next
+        auto it = entries.rend();
+        cond.wait(lock, [&] {
+            it = std::find_if(entries.rbegin(), entries.rend(), [](const Entry& entry) {
+                return !entry.fReady && !entry.fBuilding;
+            });
+            return fInterrupt || it != entries.rend();
+        });
+        if (fInterrupt)
+            break;
+
+        it->fBuilding = true;
+        uint256 hashTip = it->hashTip;
+        int nPoWVersion = it->nPoWVersion;
+        lock.unlock();
+        LatticeRoundTable table;
+        BuildTable(hashTip, nPoWVersion, table);
+        lock.lock();
+        Store(hashTip, nPoWVersion, table);
+        cond.notify_all();
+    }
+}
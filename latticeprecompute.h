@@ -0,0 +1,114 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_LATTICEPRECOMPUTE_H
+#define LATTICE_LATTICEPRECOMPUTE_H
+
+#include "hash.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/** Candidate tips kept ready; a race rarely has more than two or three contenders */
+static const size_t DEFAULT_PRECOMPUTE_TIPS = 4;
+/** Header bytes ahead of nBits and nNonce: version, prev block, merkle root, time */
+static const size_t LATTICE_HEADER_PREFIX_SIZE = 72;
+
+/** What a miner needs to start hashing on top of one tip */
+struct LatticeTipState {
+    LatticeRoundTable table;
+    bool fPrefix;                                           // A speculative header prefix was supplied
+    unsigned char prefix[LATTICE_HEADER_PREFIX_SIZE];
+    uint64_t midstate[25];                                  // Keccak512_80Prefix of prefix
+
+    /** midstate if header starts with the speculative prefix, else null */
+    const uint64_t* GetMidstate(const unsigned char* header) const;
+};
+
+/**
+ * Speculative per-tip precomputation for chain races.
+ *
+ * When a competing block header shows up, AddCandidate() queues its hash
+ * as a possible next hashPrevBlock and a background thread builds the
+ * round table for it, expanding the tip's XOF matrix. Whichever candidate
+ * wins, GetTip() then hands back a ready table instead of stalling the
+ * switch on matrix expansion. Only LATTICE_POW_VERSION_XOF and later have a
+ * per-tip matrix; older versions share the v1/v2 matrix, so their tables
+ * cost next to nothing and are never queued.
+ *
+ * Candidates are kept in LRU order, at most nMaxTips of them; a tip looked
+ * up with GetTip() counts as used. Each state owns its matrix, so it stays
+ * valid however far GetLatticeMatrixXOF's own cache has moved on.
+ */
+class CLatticePrecomputer
+{
+public:
+    explicit CLatticePrecomputer(size_t nMaxTipsIn = DEFAULT_PRECOMPUTE_TIPS);
+    ~CLatticePrecomputer();
+
+    void Start();
+    /** Finish the build in progress and stop; queued tips are built on demand by GetTip() */
+    void Stop();
+
+    /**
+     * hashTip may become the chain tip. headerPrefix, if given, is the first
+     * LATTICE_HEADER_PREFIX_SIZE bytes of the header we would mine on it
+     * (e.g. an empty-block template); its midstate is computed right away.
+     * Ignored for PoW versions without a per-tip matrix.
+     */
+    void AddCandidate(const uint256& hashTip, int nPoWVersion, const unsigned char* headerPrefix = nullptr);
+
+    /**
+     * State for mining on hashTip. A ready state is copied out at once, one
+     * the background thread is building is waited for, and anything else is
+     * built on the calling thread and kept. Tables for PoW versions without
+     * a per-tip matrix are always built on the calling thread, uncounted.
+     */
+    void GetTip(const uint256& hashTip, int nPoWVersion, LatticeTipState& tip);
+
+    /** Tips ready when asked for, waited on while building, and built on demand */
+    uint64_t GetHits() const { return nHits; }
+    uint64_t GetWaits() const { return nWaits; }
+    uint64_t GetMisses() const { return nMisses; }
+    size_t GetQueueDepth();
+
+private:
+    struct Entry {
+        uint256 hashTip;
+        int nPoWVersion;
+        bool fBuilding;
+        bool fReady;
+        LatticeTipState state;
+    };
+
+    const size_t nMaxTips;
+
+    std::mutex cs;
+    std::condition_variable cond;
+    std::deque<Entry> entries;                              // Least recently used first
+    std::atomic<bool> fInterrupt;
+    std::thread threadBuild;
+
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nWaits;
+    std::atomic<uint64_t> nMisses;
+    std::atomic<int64_t> nLastBuildMicros;
+
+    /** Entry for the tip, or entries.end(); cs must be held */
+    std::deque<Entry>::iterator Find(const uint256& hashTip, int nPoWVersion);
+    /** Find() and move the entry to the most recently used end */
+    std::deque<Entry>::iterator Touch(const uint256& hashTip, int nPoWVersion);
+    /** Drop the oldest entries not being built while over nMaxTips; cs must be held */
+    void Trim();
+    /** Build a claimed tip's round table; called without cs */
+    void BuildTable(const uint256& hashTip, int nPoWVersion, LatticeRoundTable& table);
+    /** Mark a claimed tip ready with its table; cs must be held */
+    void Store(const uint256& hashTip, int nPoWVersion, const LatticeRoundTable& table);
+    void ThreadBuild();
+};
+
+#endif // LATTICE_LATTICEPRECOMPUTE_H
@@ -0,0 +1,311 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "latticeprofile.h"
+
+#include "crypto/sha3.h"
+#include "hash.h"
+#include "latticemetrics.h"
+#include "util.h"
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> fLatticeProfile(false);
+
+static const char* const PERF_COUNTER_NAMES[NUM_PERF_COUNTERS] = {"cycles", "instr", "L1D-miss", "LLC-miss", "br-miss"};
+
+#ifdef __linux__
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} PERF_EVENTS[NUM_PERF_COUNTERS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+/** The calling thread's counter group; the first counter that opens leads it */
+struct PerfGroup {
+    bool fOpened;
+    int nLeader;
+    int fd[NUM_PERF_COUNTERS];
+    int nSlot[NUM_PERF_COUNTERS];   // Position in the group read, or -1
+    int nOpen;
+
+    PerfGroup() : fOpened(false), nLeader(-1), nOpen(0)
+    {
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+            fd[i] = -1;
+            nSlot[i] = -1;
+        }
+    }
+
+    ~PerfGroup()
+    {
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+            if (fd[i] >= 0)
+                close(fd[i]);
+        }
+    }
+
+    void Open()
+    {
+        fOpened = true;
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_EVENTS[i].type;
+            attr.config = PERF_EVENTS[i].config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            int nGroupFd = nLeader >= 0 ? fd[nLeader] : -1;
+            fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, nGroupFd, 0);
+            if (fd[i] < 0)
+                continue;
+            if (nLeader < 0)
+                nLeader = i;
+            nSlot[i] = nOpen++;
+        }
+    }
+
+    bool Read(PerfSample& sample)
+    {
+        if (!fOpened)
+            Open();
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+            sample.value[i] = 0;
+            sample.fValid[i] = false;
+        }
+        if (nLeader < 0)
+            return false;
+
+        uint64_t buf[3 + NUM_PERF_COUNTERS];
+        ssize_t nSize = (3 + nOpen) * sizeof(uint64_t);
+        if (read(fd[nLeader], buf, nSize) != nSize || buf[0] != (uint64_t)nOpen)
+            return false;
+        // Scale up if the kernel multiplexed the group off the PMU for a while
+        double nScale = buf[2] > 0 && buf[2] < buf[1] ? (double)buf[1] / buf[2] : 1.0;
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+            if (nSlot[i] < 0)
+                continue;
+            sample.value[i] = buf[3 + nSlot[i]] * nScale;
+            sample.fValid[i] = true;
+        }
+        return true;
+    }
+};
+
+static thread_local PerfGroup perfGroup;
+
+bool ReadPerfCounters(PerfSample& sample)
+{
+    return perfGroup.Read(sample);
+}
+
+static std::string GetProfileThreadName()
+{
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    return strprintf("%s#%d", name, GetMetricThreadSlot());
+}
+#else
+bool ReadPerfCounters(PerfSample& sample)
+{
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        sample.value[i] = 0;
+        sample.fValid[i] = false;
+    }
+    return false;
+}
+
+static std::string GetProfileThreadName()
+{
+    return strprintf("thread#%d", GetMetricThreadSlot());
+}
+#endif
+
+struct PerfTotals {
+    uint64_t value[NUM_PERF_COUNTERS];
+    bool fValid[NUM_PERF_COUNTERS];
+    uint64_t nItems;
+};
+
+static std::mutex cs_profile;
+static std::map<std::pair<std::string, std::string>, PerfTotals> mapProfile;
+
+bool EnableLatticeProfile()
+{
+    PerfSample sample;
+    if (!ReadPerfCounters(sample)) {
+        LogPrintf("Lattice profile: hardware counters unavailable (perf_event_open failed)\n");
+        return false;
+    }
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        if (!sample.fValid[i])
+            LogPrintf("Lattice profile: %s counter not supported here\n", PERF_COUNTER_NAMES[i]);
+    }
+    fLatticeProfile = true;
+    return true;
+}
+
+CPerfScope::CPerfScope(const char* stageIn, uint64_t nItemsIn) : stage(stageIn), nItems(nItemsIn), fActive(false)
+{
+    if (fLatticeProfile)
+        fActive = ReadPerfCounters(start);
+}
+
+CPerfScope::~CPerfScope()
+{
+    if (!fActive)
+        return;
+    PerfSample end;
+    if (!ReadPerfCounters(end))
+        return;
+
+    std::string strThread = GetProfileThreadName();
+    std::lock_guard<std::mutex> lock(cs_profile);
+    auto it = mapProfile.find(std::make_pair(std::string(stage), strThread));
+    if (it == mapProfile.end()) {
+        PerfTotals totals;
+        memset(&totals, 0, sizeof(totals));
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++)
+            totals.fValid[i] = true;
+        it = mapProfile.emplace(std::make_pair(std::string(stage), strThread), totals).first;
+    }
+    PerfTotals& totals = it->second;
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        totals.fValid[i] = totals.fValid[i] && start.fValid[i] && end.fValid[i];
+        if (end.value[i] > start.value[i])
+            totals.value[i] += end.value[i] - start.value[i];
+    }
+    totals.nItems += nItems;
+}
+
+void ResetLatticeProfile()
+{
+    std::lock_guard<std::mutex> lock(cs_profile);
+    mapProfile.clear();
+}
+
+std::string FormatLatticeProfile()
+{
+    std::lock_guard<std::mutex> lock(cs_profile);
+    std::string str = strprintf("%-18s %-22s %10s", "stage", "thread", "items");
+    for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+        str += strprintf(" %10s", PERF_COUNTER_NAMES[i]);
+    }
+    str += strprintf(" %6s\n", "IPC");
+
+    for (const auto& entry : mapProfile) {
+        const PerfTotals& totals = entry.second;
+        double nItems = std::max<uint64_t>(totals.nItems, 1);
+        str += strprintf("%-18s %-22s %10u", entry.first.first, entry.first.second, totals.nItems);
+        for (int i = 0; i < NUM_PERF_COUNTERS; i++) {
+            if (totals.fValid[i]) {
+                str += strprintf(" %10.1f", totals.value[i] / nItems);
+            } else {
+                str += strprintf(" %10s", "n/a");
+            }
+        }
+        if (totals.fValid[PERF_CYCLES] && totals.fValid[PERF_INSTRUCTIONS] && totals.value[PERF_CYCLES] > 0) {
+            str += strprintf(" %6.2f\n", (double)totals.value[PERF_INSTRUCTIONS] / totals.value[PERF_CYCLES]);
+        } else {
+            str += strprintf(" %6s\n", "n/a");
+        }
+    }
+    return str;
+}
+
+void ProfileLatticeStages(uint64_t nItems)
+{
+    // Private matrix and table so the global lattice matrix stays untouched
+    LatticeMatrix matrix;
+    ExpandLatticeMatrixXOF(uint256(), LATTICE_MATRIX_SIZE, LATTICE_MATRIX_SIZE, matrix[0].data());
+    LatticeRoundTable table;
+    table.nVersion = LATTICE_POW_VERSION_SINGLE;
+    table.matrix = &matrix;
+    for (int round = 0; round < LATTICE_ROUNDS; round++) {
+        table.kernel[round] = latticeMatrixMultiplyBackend;
+    }
+
+    unsigned char header[80];
+    for (int i = 0; i < 80; i++)
+        header[i] = (unsigned char)(i * 13);
+    unsigned char digest[64];
+    uint32_t nSink = 0;
+
+    {
+        CPerfScope scope("keccak_header", nItems);
+        for (uint64_t n = 0; n < nItems; n++) {
+            WriteLE32(header + 76, (uint32_t)n);
+            Keccak512_80(header, digest);
+            nSink += digest[0];
+        }
+    }
+    {
+        CPerfScope scope("error_vector", nItems);
+        LatticeVector error;
+        uint256 seed;
+        for (uint64_t n = 0; n < nItems; n++) {
+            WriteLE32(seed.begin(), (uint32_t)n);
+            GenerateErrorVector(seed, error);
+            nSink += error[0];
+        }
+    }
+    {
+        CPerfScope scope("modular_reduce", nItems);
+        uint64_t x = 0x9E3779B97F4A7C15ULL;
+        for (uint64_t n = 0; n < nItems; n++) {
+            for (int i = 0; i < LATTICE_DIMENSION; i++) {
+                x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+                nSink += ModularReduce((int64_t)(x >> 8) - (int64_t)(x >> 9));
+            }
+        }
+    }
+    {
+        CPerfScope scope("round_kernel", nItems * LATTICE_ROUNDS);
+        LatticeVector vector, result;
+        for (int i = 0; i < LATTICE_DIMENSION; i++)
+            vector[i] = i * 401 % LATTICE_MODULUS;
+        for (uint64_t n = 0; n < nItems; n++) {
+            for (int round = 0; round < LATTICE_ROUNDS; round++) {
+                table.kernel[round](vector, *table.matrix, result);
+                vector[round] = result[round];
+            }
+        }
+        nSink += vector[0];
+    }
+    {
+        CPerfScope scope("keccak_round", nItems * LATTICE_ROUNDS);
+        unsigned char bytes[LATTICE_DIMENSION * 4] = {};
+        for (uint64_t n = 0; n < nItems * LATTICE_ROUNDS; n++) {
+            WriteLE32(bytes, (uint32_t)n);
+            Keccak512_32(bytes, digest);
+            nSink += digest[0];
+        }
+    }
+    {
+        CPerfScope scope("hash_lattice_pow", nItems);
+        for (uint64_t n = 0; n < nItems; n++) {
+            WriteLE32(header + 76, (uint32_t)n);
+            nSink += HashLatticePOW(header, header + sizeof(header), table).GetCheapHash();
+        }
+    }
+
+    volatile uint32_t nKeep = nSink;
+    (void)nKeep;
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_LATTICEPROFILE_H
+#define LATTICE_LATTICEPROFILE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+static const bool DEFAULT_LATTICE_PROFILE = false;
+
+enum PerfCounter {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    NUM_PERF_COUNTERS
+};
+
+/** One reading of the hardware counters; fValid is false where a counter is unsupported */
+struct PerfSample {
+    uint64_t value[NUM_PERF_COUNTERS];
+    bool fValid[NUM_PERF_COUNTERS];
+};
+
+/** Set by EnableLatticeProfile(), e.g. for the benches' -profile; CPerfScope does nothing while it is false */
+extern std::atomic<bool> fLatticeProfile;
+
+/**
+ * Start profiling. Opens a counter group for the calling thread to check
+ * that perf_event_open works here (kernel.perf_event_paranoid <= 2 and
+ * hardware counters exposed); returns false and stays disabled if not.
+ */
+bool EnableLatticeProfile();
+
+/** Read this thread's counters, opening its group on first use */
+bool ReadPerfCounters(PerfSample& sample);
+
+/**
+ * Counts hardware events between construction and destruction and adds
+ * them to the (stage, thread) totals. Wrap batches rather than single
+ * hashes: each end point costs a read() system call.
+ */
+class CPerfScope
+{
+public:
+    CPerfScope(const char* stageIn, uint64_t nItemsIn = 1);
+    ~CPerfScope();
+
+    /** Items processed in the scope, if only known at the end */
+    void SetItems(uint64_t nItemsIn) { nItems = nItemsIn; }
+
+private:
+    const char* stage;
+    uint64_t nItems;
+    bool fActive;
+    PerfSample start;
+};
+
+/**
+ * Time each HashLatticePOW stage in isolation (header Keccak, error vector,
+ * ModularReduce, round kernels, round Keccak) and the whole hash, in
+ * batches of nItems on the calling thread.
+ */
+void ProfileLatticeStages(uint64_t nItems);
+
+/** Per stage and thread: cycles, instructions and misses per item, IPC */
+std::string FormatLatticeProfile();
+void ResetLatticeProfile();
+
+#endif // LATTICE_LATTICEPROFILE_H
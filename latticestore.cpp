@@ -0,0 +1,320 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "latticestore.h"
+
+#include "compat.h"
+#include "crypto/common.h"
+#include "crypto/sha3.h"
+#include "hash.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unique_ptr<CLatticeMatrixStore> pLatticeMatrixStore;
+
+static const unsigned char LATTICE_MATRIX_MAGIC[8] = {'L', 'A', 'T', 'M', 'A', 'T', 'R', 'X'};
+static const char* const LATTICE_MATRIX_SUFFIX = ".mat";
+
+/**
+ * SHAKE128 of each quarter of the matrix, four-wide through KeccakF4, then
+ * SHAKE128 of the four results and the length. Verifying the mapping then
+ * costs about as much as one XOF expansion rather than four.
+ */
+static void MatrixDigest(const unsigned char* data, size_t len, unsigned char digest[32])
+{
+    static const size_t RATE = CSHAKE128::RATE;
+    uint64_t st[25][4] = {};
+
+    // Whole blocks in the first three quarters, the rest in the last
+    size_t nQuarter = len / 4 / RATE * RATE;
+    const unsigned char* pos[4];
+    const unsigned char* end[4];
+    for (int k = 0; k < 4; k++) {
+        pos[k] = data + k * nQuarter;
+        end[k] = k < 3 ? pos[k] + nQuarter : data + len;
+    }
+
+    unsigned char lanes[4][32];
+    bool fDone[4] = {};
+    int nDone = 0;
+    while (nDone < 4) {
+        bool fPadded[4] = {};
+        for (int k = 0; k < 4; k++) {
+            if (fDone[k])
+                continue;
+            size_t nLeft = end[k] - pos[k];
+            if (nLeft >= RATE) {
+                for (size_t i = 0; i < RATE / 8; i++) {
+                    st[i][k] ^= ReadLE64(pos[k] + 8 * i);
+                }
+                pos[k] += RATE;
+            } else {
+                // SHAKE domain separation and pad10*1, as in CSHAKE128::Squeeze
+                for (size_t p = 0; p < nLeft; p++) {
+                    st[p / 8][k] ^= (uint64_t)pos[k][p] << (8 * (p % 8));
+                }
+                st[nLeft / 8][k] ^= (uint64_t)0x1F << (8 * (nLeft % 8));
+                st[(RATE - 1) / 8][k] ^= (uint64_t)0x80 << (8 * ((RATE - 1) % 8));
+                pos[k] = end[k];
+                fPadded[k] = true;
+            }
+        }
+        KeccakF4(st);
+        for (int k = 0; k < 4; k++) {
+            if (!fPadded[k])
+                continue;
+            for (size_t p = 0; p < 32; p++) {
+                lanes[k][p] = st[p / 8][k] >> (8 * (p % 8));
+            }
+            fDone[k] = true;
+            nDone++;
+        }
+    }
+
+    unsigned char nLen[8];
+    WriteLE64(nLen, len);
+    CSHAKE128().Write(lanes[0], sizeof(lanes)).Write(nLen, sizeof(nLen)).Squeeze(digest, 32);
+}
+
+static void WriteMatrixHeader(unsigned char* data, LatticeMatrixKind kind, const uint256& seed, uint32_t nRows, uint32_t nCols,
+                              const unsigned char digest[32])
+{
+    memset(data, 0, LATTICE_MATRIX_FILE_HEADER_SIZE);
+    memcpy(data, LATTICE_MATRIX_MAGIC, 8);
+    WriteLE32(data + 8, LATTICE_MATRIX_STORE_VERSION);
+    WriteLE32(data + 12, kind);
+    WriteLE32(data + 16, nRows);
+    WriteLE32(data + 20, nCols);
+    WriteLE32(data + 24, LATTICE_MODULUS);
+    memcpy(data + 32, seed.begin(), 32);
+    memcpy(data + 64, digest, 32);
+    WriteLE64(data + 96, CSipHasher(0, 0).Write(data, 96).Finalize());
+}
+
+CLatticeMatrixMapping::CLatticeMatrixMapping(void* pMapIn, size_t nMapSizeIn, uint32_t nRowsIn, uint32_t nColsIn) :
+    pMap(pMapIn), nMapSize(nMapSizeIn), nRows(nRowsIn), nCols(nColsIn)
+{
+}
+
+CLatticeMatrixMapping::~CLatticeMatrixMapping()
+{
+    munmap(pMap, nMapSize);
+}
+
+const uint32_t* CLatticeMatrixMapping::Data() const
+{
+    return reinterpret_cast<const uint32_t*>(static_cast<const unsigned char*>(pMap) + LATTICE_MATRIX_FILE_HEADER_SIZE);
+}
+
+CLatticeMatrixStore::CLatticeMatrixStore(const std::string& strDirIn, uint64_t nMaxBytesIn) :
+    strDir(strDirIn), nMaxBytes(nMaxBytesIn), nMapped(0), nWritten(0), nCorrupt(0)
+{
+}
+
+bool CLatticeMatrixStore::Open()
+{
+    // Matrices are mapped as they are stored, little-endian
+    uint32_t nOne = 1;
+    if (*reinterpret_cast<const unsigned char*>(&nOne) != 1) {
+        LogPrintf("Lattice store: disabled on big-endian hosts\n");
+        return false;
+    }
+    if (mkdir(strDir.c_str(), 0755) != 0 && errno != EEXIST) {
+        LogPrintf("Lattice store: unable to create %s: %s\n", strDir, strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (stat(strDir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        LogPrintf("Lattice store: %s is not a directory\n", strDir);
+        return false;
+    }
+    return true;
+}
+
+std::string CLatticeMatrixStore::GetPath(LatticeMatrixKind kind, const uint256& seed, uint32_t nRows, uint32_t nCols) const
+{
+    return strprintf("%s/%s-%ux%u-%u-%s%s", strDir, kind == LATTICE_MATRIX_KECCAK ? "keccak" : "xof", nRows, nCols,
+                     LATTICE_MODULUS, seed.GetHex(), LATTICE_MATRIX_SUFFIX);
+}
+
+std::shared_ptr<const CLatticeMatrixMapping> CLatticeMatrixStore::Map(const std::string& strPath, LatticeMatrixKind kind,
+                                                                      const uint256& seed, uint32_t nRows, uint32_t nCols,
+                                                                      bool fVerify, bool& fCorrupt)
+{
+    fCorrupt = false;
+    int fd = open(strPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno != ENOENT)
+            LogPrintf("Lattice store: unable to open %s: %s\n", strPath, strerror(errno));
+        return nullptr;
+    }
+    size_t nPayload = (size_t)nRows * nCols * sizeof(uint32_t);
+    size_t nFileSize = LATTICE_MATRIX_FILE_HEADER_SIZE + nPayload;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != nFileSize) {
+        close(fd);
+        fCorrupt = true;
+        return nullptr;
+    }
+    void* map = mmap(nullptr, nFileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        LogPrintf("Lattice store: mmap of %s failed: %s\n", strPath, strerror(errno));
+        return nullptr;
+    }
+    std::shared_ptr<const CLatticeMatrixMapping> mapping = std::make_shared<CLatticeMatrixMapping>(map, nFileSize, nRows, nCols);
+
+    const unsigned char* data = static_cast<const unsigned char*>(map);
+    if (memcmp(data, LATTICE_MATRIX_MAGIC, 8) != 0 || ReadLE64(data + 96) != CSipHasher(0, 0).Write(data, 96).Finalize() ||
+        ReadLE32(data + 8) != LATTICE_MATRIX_STORE_VERSION || ReadLE32(data + 12) != (uint32_t)kind ||
+        ReadLE32(data + 16) != nRows || ReadLE32(data + 20) != nCols || ReadLE32(data + 24) != LATTICE_MODULUS ||
+        memcmp(data + 32, seed.begin(), 32) != 0) {
+        fCorrupt = true;
+        return nullptr;
+    }
+    if (!fVerify)
+        return mapping;
+    // Reads every page, so the kernels start on a warm mapping
+    unsigned char digest[32];
+    MatrixDigest(data + LATTICE_MATRIX_FILE_HEADER_SIZE, nPayload, digest);
+    if (memcmp(data + 64, digest, 32) != 0) {
+        fCorrupt = true;
+        return nullptr;
+    }
+    return mapping;
+}
+
+bool CLatticeMatrixStore::Write(const std::string& strPath, LatticeMatrixKind kind, const uint256& seed, uint32_t nRows, uint32_t nCols,
+                                const std::vector<uint32_t>& vMatrix)
+{
+    const unsigned char* payload = reinterpret_cast<const unsigned char*>(vMatrix.data());
+    size_t nPayload = vMatrix.size() * sizeof(uint32_t);
+    unsigned char digest[32];
+    MatrixDigest(payload, nPayload, digest);
+    std::vector<unsigned char> vHeader(LATTICE_MATRIX_FILE_HEADER_SIZE);
+    WriteMatrixHeader(vHeader.data(), kind, seed, nRows, nCols, digest);
+
+    std::string strTemp = strprintf("%s.new.%d", strPath, getpid());
+    FILE* file = fopen(strTemp.c_str(), "wb");
+    if (file == nullptr) {
+        LogPrintf("Lattice store: unable to write %s\n", strTemp);
+        return false;
+    }
+    bool fOk = fwrite(vHeader.data(), 1, vHeader.size(), file) == vHeader.size() &&
+               fwrite(payload, 1, nPayload, file) == nPayload && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    fOk = fclose(file) == 0 && fOk;
+    if (!fOk || rename(strTemp.c_str(), strPath.c_str()) != 0) {
+        LogPrintf("Lattice store: unable to write %s\n", strPath);
+        remove(strTemp.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const CLatticeMatrixMapping> CLatticeMatrixStore::Get(LatticeMatrixKind kind, const uint256& seed, uint32_t nRows, uint32_t nCols,
+                                                                      const std::function<void(uint32_t* matrix)>& fnExpand)
+{
+    std::string strPath = GetPath(kind, seed, nRows, nCols);
+    std::lock_guard<std::mutex> lock(cs);
+    auto it = mapOpen.find(strPath);
+    if (it != mapOpen.end()) {
+        std::shared_ptr<const CLatticeMatrixMapping> mapping = it->second.lock();
+        if (mapping)
+            return mapping;
+        mapOpen.erase(it);
+    }
+
+    bool fCorrupt;
+    std::shared_ptr<const CLatticeMatrixMapping> mapping = Map(strPath, kind, seed, nRows, nCols, true, fCorrupt);
+    if (!mapping) {
+        // Whoever takes the lock second maps what the first one wrote
+        std::string strLock = strDir + "/.lock";
+        int fdLock = open(strLock.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fdLock < 0 || flock(fdLock, LOCK_EX) != 0) {
+            LogPrintf("Lattice store: unable to lock %s: %s\n", strLock, strerror(errno));
+            if (fdLock >= 0)
+                close(fdLock);
+            return nullptr;
+        }
+        mapping = Map(strPath, kind, seed, nRows, nCols, true, fCorrupt);
+        bool fWritten = false;
+        if (!mapping) {
+            if (fCorrupt) {
+                nCorrupt++;
+                LogPrintf("Lattice store: %s failed verification, rewriting\n", strPath);
+            }
+            std::vector<uint32_t> vMatrix((size_t)nRows * nCols);
+            fnExpand(vMatrix.data());
+            if (Write(strPath, kind, seed, nRows, nCols, vMatrix)) {
+                nWritten++;
+                fWritten = true;
+                // Digested from memory just now; mapping it faults in what was written
+                mapping = Map(strPath, kind, seed, nRows, nCols, false, fCorrupt);
+            }
+        }
+        flock(fdLock, LOCK_UN);
+        close(fdLock);
+        if (fWritten)
+            Prune();
+    }
+    if (!mapping)
+        return nullptr;
+
+    nMapped++;
+    for (auto entry = mapOpen.begin(); entry != mapOpen.end();) {
+        if (entry->second.expired()) {
+            entry = mapOpen.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+    mapOpen[strPath] = mapping;
+    return mapping;
+}
+
+void CLatticeMatrixStore::Prune()
+{
+    DIR* dir = opendir(strDir.c_str());
+    if (dir == nullptr)
+        return;
+    std::vector<std::pair<int64_t, std::pair<std::string, uint64_t>>> vFiles;
+    uint64_t nTotal = 0;
+    size_t nSuffix = strlen(LATTICE_MATRIX_SUFFIX);
+    for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        std::string strName = entry->d_name;
+        if (strName.size() <= nSuffix || strName.compare(strName.size() - nSuffix, nSuffix, LATTICE_MATRIX_SUFFIX) != 0)
+            continue;
+        std::string strPath = strDir + "/" + strName;
+        struct stat st;
+        if (stat(strPath.c_str(), &st) != 0)
+            continue;
+        vFiles.emplace_back((int64_t)st.st_mtime, std::make_pair(strPath, (uint64_t)st.st_size));
+        nTotal += st.st_size;
+    }
+    closedir(dir);
+
+    // Oldest first; a process still mapping a removed file keeps its pages
+    std::sort(vFiles.begin(), vFiles.end());
+    for (size_t i = 0; i < vFiles.size() && nTotal > nMaxBytes; i++) {
+        if (unlink(vFiles[i].second.first.c_str()) == 0)
+            nTotal -= vFiles[i].second.second;
+    }
+}
+
+std::shared_ptr<const CLatticeMatrixMapping> GetStoredLatticeMatrixXOF(const uint256& seed, uint32_t nRows, uint32_t nCols, int nThreads)
+{
+    if (!pLatticeMatrixStore)
+        return nullptr;
+    return pLatticeMatrixStore->Get(LATTICE_MATRIX_XOF, seed, nRows, nCols, [&](uint32_t* matrix) {
+        ExpandLatticeMatrixXOF(seed, nRows, nCols, matrix, nThreads);
+    });
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_LATTICESTORE_H
+#define LATTICE_LATTICESTORE_H
+
+#include "uint256.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+static const char* const DEFAULT_LATTICE_MATRIX_DIR = "latticematrix";
+/** Matrix files kept before the oldest are pruned; per-block XOF matrices would otherwise pile up */
+static const uint64_t DEFAULT_LATTICE_MATRIX_STORE_BYTES = (uint64_t)1 << 30;
+/** Smaller matrices expand faster than a file can be opened and verified, so they bypass the store */
+static const size_t LATTICE_MATRIX_STORE_MIN_BYTES = 1 << 16;
+/** Bump whenever a matrix expansion changes its output; older files are then rewritten */
+static const uint32_t LATTICE_MATRIX_STORE_VERSION = 1;
+/** Matrix data starts on a page boundary so kernels read it straight from the mapping */
+static const size_t LATTICE_MATRIX_FILE_HEADER_SIZE = 4096;
+/** Magic, version, kind, rows, cols, modulus, reserved, seed, SHAKE128 digest, header checksum */
+static const size_t LATTICE_MATRIX_FILE_HEADER_USED = 104;
+
+enum LatticeMatrixKind : uint32_t {
+    LATTICE_MATRIX_KECCAK = 1,      // InitializeLatticeMatrix, one Keccak-512 per element
+    LATTICE_MATRIX_XOF = 2,         // ExpandLatticeMatrixXOF
+};
+
+/** A stored matrix mapped read-only: nRows * nCols uint32_t, row-major */
+class CLatticeMatrixMapping
+{
+public:
+    CLatticeMatrixMapping(void* pMapIn, size_t nMapSizeIn, uint32_t nRowsIn, uint32_t nColsIn);
+    ~CLatticeMatrixMapping();
+
+    const uint32_t* Data() const;
+    uint32_t GetRows() const { return nRows; }
+    uint32_t GetCols() const { return nCols; }
+
+private:
+    void* pMap;
+    size_t nMapSize;
+    uint32_t nRows;
+    uint32_t nCols;
+
+    CLatticeMatrixMapping(const CLatticeMatrixMapping&) = delete;
+    CLatticeMatrixMapping& operator=(const CLatticeMatrixMapping&) = delete;
+};
+
+/**
+ * Directory of expanded lattice matrices shared by every process on a host.
+ *
+ * One file per (kind, seed, rows, cols, modulus): a page-sized header with
+ * the parameters, a SHAKE128 digest of the matrix and a header checksum,
+ * then the matrix as little-endian uint32_t. Files are written to a
+ * temporary name and renamed into place, so readers only ever see complete
+ * ones; expansion happens under a lock on the directory's .lock file, so
+ * concurrent processes expand a matrix once.
+ *
+ * Everyone maps the files MAP_SHARED read-only, so a host keeps one copy
+ * in the page cache however many nodes, miners and tools use it. The digest
+ * is checked when a process first maps a file, which also faults it in; a
+ * mismatch is logged and the file rewritten.
+ */
+class CLatticeMatrixStore
+{
+public:
+    CLatticeMatrixStore(const std::string& strDirIn, uint64_t nMaxBytesIn = DEFAULT_LATTICE_MATRIX_STORE_BYTES);
+
+    /** Create the directory if needed; false if it is unusable */
+    bool Open();
+
+    /**
+     * Matrix of kind for seed at nRows x nCols, from the store if present,
+     * otherwise filled by fnExpand and published. Null on I/O errors, in
+     * which case callers expand it themselves.
+     */
+    std::shared_ptr<const CLatticeMatrixMapping> Get(LatticeMatrixKind kind, const uint256& seed, uint32_t nRows, uint32_t nCols,
+                                                     const std::function<void(uint32_t* matrix)>& fnExpand);
+
+    /** Delete the oldest matrix files until the rest fit in nMaxBytes; existing mappings stay valid */
+    void Prune();
+
+    uint64_t GetMapped() const { return nMapped; }
+    uint64_t GetWritten() const { return nWritten; }
+    uint64_t GetCorrupt() const { return nCorrupt; }
+
+private:
+    const std::string strDir;
+    const uint64_t nMaxBytes;
+
+    std::mutex cs;
+    std::map<std::string, std::weak_ptr<const CLatticeMatrixMapping>> mapOpen;
+
+    std::atomic<uint64_t> nMapped;
+    std::atomic<uint64_t> nWritten;
+    std::atomic<uint64_t> nCorrupt;
+
+    std::string GetPath(LatticeMatrixKind kind, const uint256& seed, uint32_t nRows, uint32_t nCols) const;
+    /** Map a file and check its header, and its digest if fVerify; null if it is missing, stale or corrupt (fCorrupt set for the latter two) */
+    std::shared_ptr<const CLatticeMatrixMapping> Map(const std::string& strPath, LatticeMatrixKind kind, const uint256& seed,
+                                                     uint32_t nRows, uint32_t nCols, bool fVerify, bool& fCorrupt);
+    bool Write(const std::string& strPath, LatticeMatrixKind kind, const uint256& seed, uint32_t nRows, uint32_t nCols,
+               const std::vector<uint32_t>& vMatrix);
+};
+
+/**
+ * Store used by GetLatticeMatrixXOF once LatticeMatrix reaches
+ * LATTICE_MATRIX_STORE_MIN_BYTES, and by GetStoredLatticeMatrixXOF for
+ * larger parameter sets; set up before hashing starts.
+ */
+extern std::unique_ptr<CLatticeMatrixStore> pLatticeMatrixStore;
+
+/** ExpandLatticeMatrixXOF of any dimension through pLatticeMatrixStore; null without a usable store */
+std::shared_ptr<const CLatticeMatrixMapping> GetStoredLatticeMatrixXOF(const uint256& seed, uint32_t nRows, uint32_t nCols,
+                                                                       int nThreads = 1);
+
+#endif // LATTICE_LATTICESTORE_H
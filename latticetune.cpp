@@ -0,0 +1,283 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "latticetune.h"
+
+#include "util.h"
+#include "utilstrencodings.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+static_assert(LATTICE_DIMENSION == 8 && LATTICE_MATRIX_SIZE == 8, "SIMD lattice backends assume an 8x8 matrix");
+static_assert(sizeof(LatticeMatrix) == 64 * sizeof(uint32_t), "LatticeMatrix must be contiguous");
+
+#ifdef ENABLE_SSE41
+namespace lattice_sse41 {
+void MatrixMultiply8(const uint32_t* vector, const uint32_t* matrix, uint32_t* sums);
+}
+#endif
+
+#ifdef ENABLE_AVX2
+namespace lattice_avx2 {
+void MatrixMultiply8(const uint32_t* vector, const uint32_t* matrix, uint32_t* sums);
+}
+#endif
+
+// All backends rely on vector and matrix entries being reduced below
+// LATTICE_MODULUS, so a row sum stays below 8 * 3329^2 < 2^27.
+
+/** Scalar with 32-bit accumulation and one reduction per row */
+static void MatrixMultiplyScalar32(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result)
+{
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        uint32_t sum = 0;
+        for (int j = 0; j < LATTICE_DIMENSION; j++) {
+            sum += vector[j] * matrix[i][j];
+        }
+        result[i] = sum % LATTICE_MODULUS;
+    }
+}
+
+#ifdef ENABLE_SSE41
+static void MatrixMultiplySSE41(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result)
+{
+    uint32_t sums[LATTICE_DIMENSION];
+    lattice_sse41::MatrixMultiply8(vector.data(), matrix[0].data(), sums);
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        result[i] = sums[i] % LATTICE_MODULUS;
+    }
+}
+#endif
+
+#ifdef ENABLE_AVX2
+static void MatrixMultiplyAVX2(const LatticeVector& vector, const LatticeMatrix& matrix, LatticeVector& result)
+{
+    uint32_t sums[LATTICE_DIMENSION];
+    lattice_avx2::MatrixMultiply8(vector.data(), matrix[0].data(), sums);
+    for (int i = 0; i < LATTICE_DIMENSION; i++) {
+        result[i] = sums[i] % LATTICE_MODULUS;
+    }
+}
+#endif
+
+std::vector<LatticeBackend> GetLatticeBackends()
+{
+    std::vector<LatticeBackend> vBackends;
+    vBackends.push_back({"reference", LatticeMatrixMultiply});
+    vBackends.push_back({"scalar32", MatrixMultiplyScalar32});
+#if defined(ENABLE_SSE41) && (defined(__x86_64__) || defined(__i386__))
+    if (__builtin_cpu_supports("sse4.1"))
+        vBackends.push_back({"sse4.1", MatrixMultiplySSE41});
+#endif
+#if defined(ENABLE_AVX2) && (defined(__x86_64__) || defined(__i386__))
+    if (__builtin_cpu_supports("avx2"))
+        vBackends.push_back({"avx2", MatrixMultiplyAVX2});
+#endif
+    return vBackends;
+}
+
+/** Deterministic known-answer inputs: Keccak-expanded values plus edge cases */
+static void FillTestVector(uint32_t nCase, LatticeVector& vector, LatticeMatrix& matrix)
+{
+    if (nCase == 0) {
+        vector.fill(LATTICE_MODULUS - 1);
+        for (auto& row : matrix)
+            row.fill(LATTICE_MODULUS - 1);
+        return;
+    }
+
+    uint8_t seed[4] = {(uint8_t)nCase, (uint8_t)(nCase >> 8), 0x7A, 0xA7};
+    uint8_t stream[64];
+    sph_keccak512_context ctx;
+    for (int i = 0; i <= LATTICE_MATRIX_SIZE; i++) {
+        seed[2] = i;
+        sph_keccak512_init(&ctx);
+        sph_keccak512(&ctx, seed, sizeof(seed));
+        sph_keccak512_close(&ctx, stream);
+        std::array<uint32_t, LATTICE_DIMENSION>& target = i < LATTICE_MATRIX_SIZE ? matrix[i] : vector;
+        for (int j = 0; j < LATTICE_DIMENSION; j++) {
+            target[j] = ((stream[j * 2] << 8) | stream[j * 2 + 1]) % LATTICE_MODULUS;
+        }
+    }
+    if (nCase == 1)
+        vector.fill(0);
+}
+
+bool LatticeBackendSelfTest(LatticeRoundKernel kernel)
+{
+    LatticeVector vector, expected, result;
+    LatticeMatrix matrix;
+    for (uint32_t nCase = 0; nCase < 256; nCase++) {
+        FillTestVector(nCase, vector, matrix);
+        LatticeMatrixMultiply(vector, matrix, expected);
+        kernel(vector, matrix, result);
+        if (result != expected)
+            return false;
+    }
+
+    // Whole hash, so any difference in how the kernel is called shows up too.
+    // Uses its own matrix so global_lattice_matrix is left untouched.
+    FillTestVector(2, vector, matrix);
+    LatticeRoundTable reference, candidate;
+    reference.nVersion = LATTICE_POW_VERSION_SINGLE;
+    reference.matrix = &matrix;
+    for (int round = 0; round < LATTICE_ROUNDS; round++) {
+        reference.kernel[round] = LatticeMatrixMultiply;
+    }
+    candidate = reference;
+    for (int round = 0; round < LATTICE_ROUNDS; round++) {
+        candidate.kernel[round] = kernel;
+    }
+    unsigned char header[80];
+    for (uint32_t nNonce = 0; nNonce < 16; nNonce++) {
+        for (int i = 0; i < 80; i++)
+            header[i] = (unsigned char)(i * 31 + nNonce);
+        if (HashLatticePOW(header, header + 80, reference) != HashLatticePOW(header, header + 80, candidate))
+            return false;
+    }
+    return true;
+}
+
+bool SelectLatticeBackend(const std::string& name)
+{
+    for (const LatticeBackend& backend : GetLatticeBackends()) {
+        if (name == backend.name) {
+            if (!LatticeBackendSelfTest(backend.kernel)) {
+                LogPrintf("Lattice backend %s failed its self-test\n", backend.name);
+                return false;
+            }
+            latticeMatrixMultiplyBackend = backend.kernel;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Kernel calls per second over roughly nMillis */
+static double BenchmarkKernel(LatticeRoundKernel kernel, int64_t nMillis)
+{
+    std::vector<LatticeVector> vVectors(16);
+    LatticeMatrix matrix;
+    for (size_t i = 0; i < vVectors.size(); i++) {
+        FillTestVector(i + 2, vVectors[i], matrix);
+    }
+
+    LatticeVector result;
+    uint32_t nSink = 0;
+    uint64_t nCalls = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds(nMillis);
+    std::chrono::steady_clock::time_point now;
+    do {
+        for (int i = 0; i < 1024; i++) {
+            LatticeVector& vector = vVectors[i & 15];
+            kernel(vector, matrix, result);
+            vector[0] = result[0];
+            nSink += result[LATTICE_DIMENSION - 1];
+        }
+        nCalls += 1024;
+        now = std::chrono::steady_clock::now();
+    } while (now < deadline);
+
+    volatile uint32_t nKeep = nSink;
+    (void)nKeep;
+    return nCalls / std::chrono::duration<double>(now - start).count();
+}
+
+/** Identifies the host and build the cached choice was made for */
+static std::string GetHostSignature()
+{
+    std::string strHost = "generic";
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int brand[12] = {};
+    unsigned int nMaxExt = __get_cpuid_max(0x80000000, nullptr);
+    if (nMaxExt >= 0x80000004) {
+        for (unsigned int i = 0; i < 3; i++) {
+            __get_cpuid(0x80000002 + i, &brand[i * 4], &brand[i * 4 + 1], &brand[i * 4 + 2], &brand[i * 4 + 3]);
+        }
+        strHost = std::string((const char*)brand, strnlen((const char*)brand, sizeof(brand)));
+    }
+#endif
+    strHost += strprintf("|%u/%u/%u|", LATTICE_MODULUS, LATTICE_DIMENSION, LATTICE_ROUNDS);
+    for (const LatticeBackend& backend : GetLatticeBackends()) {
+        strHost += backend.name;
+        strHost += ",";
+    }
+
+    uint64_t nHash = CSipHasher(0, 0).Write((const unsigned char*)strHost.data(), strHost.size()).Finalize();
+    return strprintf("%016x", nHash);
+}
+
+static bool ReadTuneFile(const std::string& strPath, const std::string& strHost, std::string& strBackend)
+{
+    std::ifstream file(strPath);
+    if (!file.is_open())
+        return false;
+
+    std::string line, strVersion, strFileHost;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t pos = line.find('=');
+        if (pos == std::string::npos)
+            continue;
+        std::string key = line.substr(0, pos), value = line.substr(pos + 1);
+        if (key == "version") strVersion = value;
+        else if (key == "host") strFileHost = value;
+        else if (key == "matmul") strBackend = value;
+    }
+    return strVersion == std::to_string(LATTICE_TUNE_FORMAT_VERSION) && strFileHost == strHost && !strBackend.empty();
+}
+
+static void WriteTuneFile(const std::string& strPath, const std::string& strHost, const std::string& strBackend)
+{
+    std::ofstream file(strPath, std::ios::trunc);
+    if (!file.is_open()) {
+        LogPrintf("Lattice autotune: unable to write %s\n", strPath);
+        return;
+    }
+    file << "# LATTICE-PoW backend selection, written by LatticeAutoTune\n";
+    file << "version=" << LATTICE_TUNE_FORMAT_VERSION << "\n";
+    file << "host=" << strHost << "\n";
+    file << "matmul=" << strBackend << "\n";
+}
+
+std::string LatticeAutoTune(const std::string& strPath, int64_t nBenchMillis)
+{
+    std::string strHost = GetHostSignature();
+
+    std::string strCached;
+    if (!strPath.empty() && ReadTuneFile(strPath, strHost, strCached) && SelectLatticeBackend(strCached)) {
+        return "matmul=" + strCached + " (cached)";
+    }
+
+    const LatticeBackend* pBest = nullptr;
+    double nBestRate = 0;
+    std::vector<LatticeBackend> vBackends = GetLatticeBackends();
+    for (const LatticeBackend& backend : vBackends) {
+        if (!LatticeBackendSelfTest(backend.kernel)) {
+            LogPrintf("Lattice autotune: %s failed its self-test, skipping\n", backend.name);
+            continue;
+        }
+        double nRate = BenchmarkKernel(backend.kernel, nBenchMillis);
+        LogPrintf("Lattice autotune: %s %.0f ops/s\n", backend.name, nRate);
+        if (nRate > nBestRate) {
+            nBestRate = nRate;
+            pBest = &backend;
+        }
+    }
+
+    // The reference always passes its own self-test
+    assert(pBest != nullptr);
+    latticeMatrixMultiplyBackend = pBest->kernel;
+    if (!strPath.empty())
+        WriteTuneFile(strPath, strHost, pBest->name);
+    return std::string("matmul=") + pBest->name;
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_LATTICETUNE_H
+#define LATTICE_LATTICETUNE_H
+
+#include "hash.h"
+
+#include <string>
+#include <vector>
+
+static const char* const DEFAULT_LATTICE_TUNE_FILE = "latticetune.conf";
+static const int LATTICE_TUNE_FORMAT_VERSION = 1;
+/** Time spent benchmarking each candidate backend */
+static const int64_t DEFAULT_LATTICE_TUNE_MILLIS = 20;
+
+/** A candidate implementation of LatticeMatrixMultiply */
+struct LatticeBackend {
+    const char* name;
+    LatticeRoundKernel kernel;
+};
+
+/** Backends compiled in and supported by this CPU, reference first */
+std::vector<LatticeBackend> GetLatticeBackends();
+
+/**
+ * Check a kernel against the reference LatticeMatrixMultiply on known-answer
+ * vectors and through a full HashLatticePOW, bit for bit.
+ */
+bool LatticeBackendSelfTest(LatticeRoundKernel kernel);
+
+/** Install a backend by name after it passes LatticeBackendSelfTest */
+bool SelectLatticeBackend(const std::string& name);
+
+/**
+ * Pick the fastest verified backend for this host and install it.
+ *
+ * The choice is cached in strPath together with a host signature (CPU brand,
+ * lattice parameters and the compiled-in backends); later starts reuse it
+ * without benchmarking as long as the signature matches. An empty path
+ * disables caching. Returns a description of the selection for the log.
+ */
+std::string LatticeAutoTune(const std::string& strPath, int64_t nBenchMillis = DEFAULT_LATTICE_TUNE_MILLIS);
+
+#endif // LATTICE_LATTICETUNE_H
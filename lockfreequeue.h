@@ -0,0 +1,178 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_LOCKFREEQUEUE_H
+#define LATTICE_LOCKFREEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * Bounded multi-producer multi-consumer queue (Vyukov). Each slot carries a
+ * sequence number, so producers and consumers only contend on their own
+ * position counter and never take a lock. Capacity is rounded up to a power
+ * of two. TryPush fails when full, which is the backpressure signal.
+ */
+template<typename T>
+class CLockFreeQueue
+{
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> buffer;
+    size_t mask;
+    // Keep the producer and consumer positions on separate cache lines
+    std::atomic<size_t> enqueuePos;
+    char padding[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> dequeuePos;
+
+public:
+    explicit CLockFreeQueue(size_t nCapacity) : enqueuePos(0), dequeuePos(0)
+    {
+        size_t nSize = 2;
+        while (nSize < nCapacity)
+            nSize <<= 1;
+        buffer.reset(new Cell[nSize]);
+        mask = nSize - 1;
+        for (size_t i = 0; i < nSize; i++) {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    CLockFreeQueue(const CLockFreeQueue&) = delete;
+    CLockFreeQueue& operator=(const CLockFreeQueue&) = delete;
+
+    size_t Capacity() const { return mask + 1; }
+
+    bool TryPush(T&& item)
+    {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &buffer[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item)
+    {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &buffer[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(cell->data);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Approximate number of queued items, for monitoring only */
+    size_t SizeApprox() const
+    {
+        size_t nEnqueued = enqueuePos.load(std::memory_order_relaxed);
+        size_t nDequeued = dequeuePos.load(std::memory_order_relaxed);
+        return nEnqueued > nDequeued ? nEnqueued - nDequeued : 0;
+    }
+};
+
+/**
+ * Bounded single-producer single-consumer ring (Lamport). Each side caches
+ * the other's position and only reloads it when the ring looks full or
+ * empty, so a push or pop is one release store on a line the other side
+ * rarely reads. Exactly one thread may push and one thread may pop.
+ */
+template<typename T>
+class CSPSCQueue
+{
+private:
+    std::unique_ptr<T[]> buffer;
+    size_t mask;
+    // Producer side: its position and its last view of the consumer's
+    std::atomic<size_t> tail;
+    size_t headCached;
+    char padding1[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    // Consumer side
+    std::atomic<size_t> head;
+    size_t tailCached;
+    char padding2[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+public:
+    explicit CSPSCQueue(size_t nCapacity) : tail(0), headCached(0), head(0), tailCached(0)
+    {
+        size_t nSize = 2;
+        while (nSize < nCapacity)
+            nSize <<= 1;
+        buffer.reset(new T[nSize]);
+        mask = nSize - 1;
+    }
+
+    CSPSCQueue(const CSPSCQueue&) = delete;
+    CSPSCQueue& operator=(const CSPSCQueue&) = delete;
+
+    size_t Capacity() const { return mask + 1; }
+
+    bool TryPush(T&& item)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        if (pos - headCached > mask) {
+            headCached = head.load(std::memory_order_acquire);
+            if (pos - headCached > mask)
+                return false;
+        }
+        buffer[pos & mask] = std::move(item);
+        tail.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        if (pos == tailCached) {
+            tailCached = tail.load(std::memory_order_acquire);
+            if (pos == tailCached)
+                return false;
+        }
+        item = std::move(buffer[pos & mask]);
+        head.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Approximate number of queued items, for monitoring only */
+    size_t SizeApprox() const
+    {
+        size_t nTail = tail.load(std::memory_order_relaxed);
+        size_t nHead = head.load(std::memory_order_relaxed);
+        return nTail > nHead ? nTail - nHead : 0;
+    }
+};
+
+#endif // LATTICE_LOCKFREEQUEUE_H
@@ -0,0 +1,228 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "mergedmining.h"
+
+#include "hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+uint32_t GetAuxChainSlot(uint32_t nChainId, uint32_t nTreeNonce, uint32_t nTreeSize)
+{
+    // Same LCG steps as the classic aux-PoW chain index, so a chain's slot is fixed by (id, nonce, size)
+    uint32_t nRand = nTreeNonce;
+    nRand = nRand * 1103515245 + 12345;
+    nRand += nChainId;
+    nRand = nRand * 1103515245 + 12345;
+    return nRand % nTreeSize;
+}
+
+/** Root of the aux merkle tree from a leaf at nIndex and its branch */
+static uint256 ComputeAuxMerkleRoot(const uint256& leaf, const std::vector<uint256>& vBranch, uint32_t nIndex)
+{
+    uint256 hash = leaf;
+    for (const uint256& sibling : vBranch) {
+        if (nIndex & 1) {
+            hash = Hash(sibling.begin(), sibling.end(), hash.begin(), hash.end());
+        } else {
+            hash = Hash(hash.begin(), hash.end(), sibling.begin(), sibling.end());
+        }
+        nIndex >>= 1;
+    }
+    return hash;
+}
+
+bool CheckAuxProof(const AuxProof& proof, uint32_t nChainId, const uint256& hashAuxBlock, uint32_t nBits,
+                   int nPoWVersion, std::string& strError)
+{
+    if (proof.vChainBranch.size() > MERGED_MINING_MAX_TREE_DEPTH) {
+        strError = "aux merkle branch too long";
+        return false;
+    }
+    uint256 hashAuxRoot = ComputeAuxMerkleRoot(hashAuxBlock, proof.vChainBranch, proof.nChainIndex);
+
+    // Exactly one commitment, so a coinbase cannot carry roots for two trees
+    const std::vector<unsigned char>& vCoinbase = proof.vCoinbase;
+    auto it = std::search(vCoinbase.begin(), vCoinbase.end(), MERGED_MINING_MAGIC, MERGED_MINING_MAGIC + 4);
+    if (it == vCoinbase.end()) {
+        strError = "no merged mining commitment in coinbase";
+        return false;
+    }
+    if (std::search(it + 1, vCoinbase.end(), MERGED_MINING_MAGIC, MERGED_MINING_MAGIC + 4) != vCoinbase.end()) {
+        strError = "multiple merged mining commitments in coinbase";
+        return false;
+    }
+    size_t nPos = it - vCoinbase.begin();
+    if (nPos + MERGED_MINING_COMMITMENT_SIZE > vCoinbase.size()) {
+        strError = "truncated merged mining commitment";
+        return false;
+    }
+    if (memcmp(&vCoinbase[nPos + 4], hashAuxRoot.begin(), 32) != 0) {
+        strError = "aux merkle root not committed";
+        return false;
+    }
+    uint32_t nTreeSize = ReadLE32(&vCoinbase[nPos + 36]);
+    uint32_t nTreeNonce = ReadLE32(&vCoinbase[nPos + 40]);
+    if (nTreeSize != (1u << proof.vChainBranch.size())) {
+        strError = "aux merkle tree size does not match branch";
+        return false;
+    }
+    if (GetAuxChainSlot(nChainId, nTreeNonce, nTreeSize) != proof.nChainIndex) {
+        strError = "aux block not at its chain's slot";
+        return false;
+    }
+
+    // The coinbase is the first leaf of the parent merkle tree
+    uint256 hashMerkleRoot = Hash(vCoinbase.begin(), vCoinbase.end());
+    for (const uint256& hash : proof.vCoinbaseBranch) {
+        hashMerkleRoot = Hash(hashMerkleRoot.begin(), hashMerkleRoot.end(), hash.begin(), hash.end());
+    }
+    if (memcmp(proof.parentHeader + 36, hashMerkleRoot.begin(), 32) != 0) {
+        strError = "coinbase not in parent merkle root";
+        return false;
+    }
+
+    bool fNegative, fOverflow;
+    arith_uint256 bnTarget;
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+    if (fNegative || fOverflow || bnTarget == 0) {
+        strError = "invalid aux target";
+        return false;
+    }
+    uint256 hashPrevBlock;
+    memcpy(hashPrevBlock.begin(), proof.parentHeader + 4, 32);
+    LatticeRoundTable table;
+    BuildLatticeRoundTable(hashPrevBlock, nPoWVersion, table);
+    uint256 powHash = HashLatticePOW(proof.parentHeader, proof.parentHeader + MERGED_MINING_HEADER_SIZE, table);
+    if (UintToArith256(powHash) > bnTarget) {
+        strError = "parent proof of work below aux target";
+        return false;
+    }
+    return true;
+}
+
+CMergedMiningWork::CMergedMiningWork(const std::vector<AuxChainWork>& vChainsIn) :
+    vChains(vChainsIn), nTreeSize(1), nTreeNonce(0), fValid(false), nEasiestHigh(0)
+{
+    std::set<uint32_t> setIds;
+    for (const AuxChainWork& chain : vChains) {
+        bool fNegative, fOverflow;
+        arith_uint256 bnTarget;
+        bnTarget.SetCompact(chain.nBits, &fNegative, &fOverflow);
+        if (!setIds.insert(chain.nChainId).second || fNegative || fOverflow || bnTarget == 0)
+            return;
+    }
+    if (vChains.empty() || !Layout())
+        return;
+
+    vTargetOrder.resize(vChains.size());
+    for (size_t i = 0; i < vChains.size(); i++)
+        vTargetOrder[i] = i;
+    std::sort(vTargetOrder.begin(), vTargetOrder.end(), [this](size_t a, size_t b) {
+        arith_uint256 bnA, bnB;
+        bnA.SetCompact(vChains[a].nBits);
+        bnB.SetCompact(vChains[b].nBits);
+        return bnA > bnB;
+    });
+    for (size_t i : vTargetOrder) {
+        vTargets.emplace_back();
+        vTargets.back().SetCompact(vChains[i].nBits);
+    }
+    nEasiestHigh = ArithToUint256(vTargets[0]).GetUint64(3);
+    fValid = true;
+}
+
+bool CMergedMiningWork::Layout()
+{
+    for (unsigned int nDepth = 0; nDepth <= MERGED_MINING_MAX_TREE_DEPTH; nDepth++) {
+        uint32_t nSize = 1u << nDepth;
+        if (nSize < vChains.size())
+            continue;
+        for (uint32_t nNonce = 0; nNonce < MERGED_MINING_MAX_TREE_NONCES; nNonce++) {
+            std::vector<bool> vUsed(nSize);
+            vSlots.clear();
+            for (const AuxChainWork& chain : vChains) {
+                uint32_t nSlot = GetAuxChainSlot(chain.nChainId, nNonce, nSize);
+                if (vUsed[nSlot])
+                    break;
+                vUsed[nSlot] = true;
+                vSlots.push_back(nSlot);
+            }
+            if (vSlots.size() < vChains.size())
+                continue;
+
+            nTreeSize = nSize;
+            nTreeNonce = nNonce;
+            vTree.assign(1, std::vector<uint256>(nSize));
+            for (size_t i = 0; i < vChains.size(); i++)
+                vTree[0][vSlots[i]] = vChains[i].hashAuxBlock;
+            while (vTree.back().size() > 1) {
+                const std::vector<uint256>& level = vTree.back();
+                std::vector<uint256> next(level.size() / 2);
+                for (size_t i = 0; i < next.size(); i++) {
+                    next[i] = Hash(level[2 * i].begin(), level[2 * i].end(), level[2 * i + 1].begin(), level[2 * i + 1].end());
+                }
+                vTree.push_back(std::move(next));
+            }
+            hashAuxRoot = vTree.back()[0];
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<uint256> CMergedMiningWork::GetChainBranch(uint32_t nSlot) const
+{
+    std::vector<uint256> vBranch;
+    for (size_t nLevel = 0; nLevel + 1 < vTree.size(); nLevel++) {
+        vBranch.push_back(vTree[nLevel][nSlot ^ 1]);
+        nSlot >>= 1;
+    }
+    return vBranch;
+}
+
+std::vector<unsigned char> CMergedMiningWork::GetCommitment() const
+{
+    std::vector<unsigned char> vCommitment(MERGED_MINING_COMMITMENT_SIZE);
+    memcpy(vCommitment.data(), MERGED_MINING_MAGIC, 4);
+    memcpy(vCommitment.data() + 4, hashAuxRoot.begin(), 32);
+    WriteLE32(vCommitment.data() + 36, nTreeSize);
+    WriteLE32(vCommitment.data() + 40, nTreeNonce);
+    return vCommitment;
+}
+
+size_t CMergedMiningWork::CheckHash(const uint256& powHash) const
+{
+    // Nearly every hash stops here, whatever the number of chains
+    if (!fValid || powHash.GetUint64(3) > nEasiestHigh)
+        return 0;
+    arith_uint256 bnHash = UintToArith256(powHash);
+    size_t n = 0;
+    while (n < vTargets.size() && bnHash <= vTargets[n])
+        n++;
+    return n;
+}
+
+size_t CMergedMiningWork::Route(const unsigned char header[MERGED_MINING_HEADER_SIZE], const std::vector<unsigned char>& vCoinbase,
+                                const std::vector<uint256>& vCoinbaseBranch, const uint256& powHash) const
+{
+    size_t nSolved = CheckHash(powHash);
+    if (nSolved == 0)
+        return 0;
+
+    AuxProof proof;
+    memcpy(proof.parentHeader, header, MERGED_MINING_HEADER_SIZE);
+    proof.vCoinbase = vCoinbase;
+    proof.vCoinbaseBranch = vCoinbaseBranch;
+    for (size_t n = 0; n < nSolved; n++) {
+        size_t i = vTargetOrder[n];
+        proof.nChainIndex = vSlots[i];
+        proof.vChainBranch = GetChainBranch(vSlots[i]);
+        if (vChains[i].SolutionFound)
+            vChains[i].SolutionFound(vChains[i], proof);
+    }
+    return nSolved;
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_MERGEDMINING_H
+#define LATTICE_MERGEDMINING_H
+
+#include "arith_uint256.h"
+#include "uint256.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Marks the aux merkle root in a parent coinbase */
+static const unsigned char MERGED_MINING_MAGIC[4] = {0xfa, 0xbe, 'm', 'm'};
+/** Magic, aux merkle root, tree size (LE32) and tree nonce (LE32) */
+static const size_t MERGED_MINING_COMMITMENT_SIZE = 44;
+/** Deepest aux merkle tree tried when laying out chains */
+static const unsigned int MERGED_MINING_MAX_TREE_DEPTH = 8;
+/** Tree nonces tried per depth before going one level deeper */
+static const uint32_t MERGED_MINING_MAX_TREE_NONCES = 256;
+static const size_t MERGED_MINING_HEADER_SIZE = 80;
+
+/**
+ * Everything an auxiliary chain needs to accept a parent block's PoW as
+ * its own: the parent header, the parent coinbase with the commitment, the
+ * coinbase's branch in the parent merkle tree, and the aux block's branch
+ * in the aux merkle tree.
+ */
+struct AuxProof {
+    unsigned char parentHeader[MERGED_MINING_HEADER_SIZE];
+    std::vector<unsigned char> vCoinbase;
+    std::vector<uint256> vCoinbaseBranch;
+    std::vector<uint256> vChainBranch;
+    uint32_t nChainIndex;
+};
+
+/** One auxiliary chain's current block */
+struct AuxChainWork {
+    uint32_t nChainId;
+    uint256 hashAuxBlock;
+    uint32_t nBits;
+    /** Called from whichever thread found a parent hash meeting this chain's target */
+    std::function<void(const AuxChainWork& chain, const AuxProof& proof)> SolutionFound;
+};
+
+/** Aux merkle tree slot of nChainId for a tree of nTreeSize leaves laid out with nTreeNonce */
+uint32_t GetAuxChainSlot(uint32_t nChainId, uint32_t nTreeNonce, uint32_t nTreeSize);
+
+/**
+ * Check proof against an aux block: the branch leads to the root committed
+ * once in the coinbase at the chain's slot, the coinbase is in the parent
+ * header's merkle root, and the parent header's HashLatticePOW meets nBits.
+ */
+bool CheckAuxProof(const AuxProof& proof, uint32_t nChainId, const uint256& hashAuxBlock, uint32_t nBits,
+                   int nPoWVersion, std::string& strError);
+
+/**
+ * Merged-mining work: auxiliary chains committed into one parent coinbase,
+ * so each parent HashLatticePOW evaluation is a candidate for all of them.
+ *
+ * Chains are placed in an aux merkle tree at slots derived from their ids;
+ * the constructor finds the smallest tree and nonce with no collisions.
+ * GetCommitment() is pushed into the parent coinbase scriptSig by whoever
+ * serializes it.
+ *
+ * Targets are kept easiest first. A hash meeting one target meets every
+ * easier one, so the chains a hash solves are a prefix of that order and
+ * CheckHash() rejects almost every hash on a single 64-bit compare against
+ * the easiest target, however many chains are merged.
+ */
+class CMergedMiningWork
+{
+public:
+    explicit CMergedMiningWork(const std::vector<AuxChainWork>& vChainsIn);
+
+    /** False if chain ids repeat or no tree up to MERGED_MINING_MAX_TREE_DEPTH fits them */
+    bool IsValid() const { return fValid; }
+
+    std::vector<unsigned char> GetCommitment() const;
+    uint256 GetAuxMerkleRoot() const { return hashAuxRoot; }
+    size_t GetChainCount() const { return vChains.size(); }
+
+    /** Number of chains whose target powHash meets; they are GetSolvedChain(0 .. n-1) */
+    size_t CheckHash(const uint256& powHash) const;
+    const AuxChainWork& GetSolvedChain(size_t n) const { return vChains[vTargetOrder[n]]; }
+
+    /**
+     * Build a proof for every chain powHash solves and hand it to the chain's
+     * SolutionFound; vCoinbase is the parent coinbase header commits to.
+     * Returns the number of chains solved.
+     */
+    size_t Route(const unsigned char header[MERGED_MINING_HEADER_SIZE], const std::vector<unsigned char>& vCoinbase,
+                 const std::vector<uint256>& vCoinbaseBranch, const uint256& powHash) const;
+
+private:
+    std::vector<AuxChainWork> vChains;
+    std::vector<uint32_t> vSlots;
+    uint32_t nTreeSize;
+    uint32_t nTreeNonce;
+    bool fValid;
+    std::vector<std::vector<uint256>> vTree;            // Leaves first, root last
+    uint256 hashAuxRoot;
+
+    std::vector<size_t> vTargetOrder;                   // Chain indexes, easiest target first
+    std::vector<arith_uint256> vTargets;                // Same order
+    uint64_t nEasiestHigh;                              // Top 64 bits of the easiest target
+
+    bool Layout();
+    std::vector<uint256> GetChainBranch(uint32_t nSlot) const;
+};
+
+#endif // LATTICE_MERGEDMINING_H
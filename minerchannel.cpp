@@ -0,0 +1,141 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "minerchannel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+CMinerResultChannel::CMinerResultChannel(int nWorkers, size_t nCapacity) : nNextRing(0), fInterrupt(false)
+{
+    for (int i = 0; i < std::max(nWorkers, 1); i++) {
+        vRings.emplace_back(new CSPSCQueue<MinerResult>(nCapacity));
+    }
+}
+
+size_t CMinerResultChannel::Drain(std::vector<MinerResult>& vResults, size_t nMax)
+{
+    // One result per ring per pass, so a busy worker cannot starve the rest
+    size_t nDrained = 0;
+    size_t nIdle = 0;
+    MinerResult result;
+    while (nDrained < nMax && nIdle < vRings.size()) {
+        CSPSCQueue<MinerResult>& ring = *vRings[nNextRing];
+        nNextRing = (nNextRing + 1) % vRings.size();
+        if (ring.TryPop(result)) {
+            vResults.push_back(std::move(result));
+            nDrained++;
+            nIdle = 0;
+        } else {
+            nIdle++;
+        }
+    }
+    return nDrained;
+}
+
+bool CMinerResultChannel::WaitForResults(int64_t nTimeoutMicros)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(nTimeoutMicros);
+    int64_t nSleepMicros = 0;
+    while (true) {
+        if (SizeApprox() > 0)
+            return true;
+        if (fInterrupt || std::chrono::steady_clock::now() >= deadline)
+            return false;
+        if (nSleepMicros == 0) {
+            std::this_thread::yield();
+            nSleepMicros = 1;
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(nSleepMicros));
+            nSleepMicros = std::min<int64_t>(nSleepMicros * 2, 1000);
+        }
+    }
+}
+
+size_t CMinerResultChannel::SizeApprox() const
+{
+    size_t nSize = 0;
+    for (const auto& ring : vRings) {
+        nSize += ring->SizeApprox();
+    }
+    return nSize;
+}
+
+CMinerReporter::CMinerReporter(CMinerResultChannel& channelIn, int nWorkerIn, const arith_uint256& targetIn) :
+    channel(channelIn), nWorker(nWorkerIn), target(targetIn), best(~arith_uint256(0)), nPendingHashes(0),
+    fPendingBest(false), nStalls(0)
+{
+}
+
+CMinerReporter::~CMinerReporter()
+{
+    Flush();
+}
+
+void CMinerReporter::Found(const unsigned char header[MINER_HEADER_SIZE], uint32_t nNonce, const uint256& hash, const arith_uint256& bnHash)
+{
+    MinerResult result;
+    result.nWorker = nWorker;
+    result.nNonce = nNonce;
+    result.hash = hash;
+    result.nHashes = 0;
+    memcpy(result.header, header, MINER_HEADER_SIZE);
+
+    if (bnHash < best) {
+        best = bnHash;
+        pendingBest = result;
+        pendingBest.type = MINER_RESULT_BEST;
+        fPendingBest = !channel.TryPush(nWorker, MinerResult(pendingBest));
+    }
+    if (bnHash <= target) {
+        result.type = MINER_RESULT_SOLUTION;
+        PushWait(std::move(result));
+    }
+}
+
+void CMinerReporter::ReportStats()
+{
+    // A full ring just means the count keeps growing until the next try
+    MinerResult result;
+    result.type = MINER_RESULT_STATS;
+    result.nWorker = nWorker;
+    result.nNonce = 0;
+    result.nHashes = nPendingHashes;
+    if (channel.TryPush(nWorker, std::move(result)))
+        nPendingHashes = 0;
+    if (fPendingBest)
+        fPendingBest = !channel.TryPush(nWorker, MinerResult(pendingBest));
+}
+
+bool CMinerReporter::PushWait(MinerResult&& result)
+{
+    if (channel.TryPush(nWorker, std::move(result)))
+        return true;
+    nStalls++;
+    while (!channel.IsInterrupted()) {
+        std::this_thread::yield();
+        if (channel.TryPush(nWorker, std::move(result)))
+            return true;
+    }
+    return false;
+}
+
+void CMinerReporter::Flush()
+{
+    if (fPendingBest) {
+        fPendingBest = false;
+        PushWait(MinerResult(pendingBest));
+    }
+    if (nPendingHashes > 0) {
+        MinerResult result;
+        result.type = MINER_RESULT_STATS;
+        result.nWorker = nWorker;
+        result.nNonce = 0;
+        result.nHashes = nPendingHashes;
+        if (PushWait(std::move(result)))
+            nPendingHashes = 0;
+    }
+}
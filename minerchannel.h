@@ -0,0 +1,122 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_MINERCHANNEL_H
+#define LATTICE_MINERCHANNEL_H
+
+#include "arith_uint256.h"
+#include "lockfreequeue.h"
+#include "uint256.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+static const size_t DEFAULT_MINER_CHANNEL_CAPACITY = 1024;
+/** Hashes a worker counts locally before it reports them */
+static const uint64_t MINER_STATS_INTERVAL = 1 << 14;
+static const size_t MINER_HEADER_SIZE = 80;
+
+enum MinerResultType {
+    MINER_RESULT_SOLUTION,  // Hash meets the share or block target
+    MINER_RESULT_BEST,      // New lowest hash seen by this worker
+    MINER_RESULT_STATS,     // Hashes done since the worker's previous report
+};
+
+struct MinerResult {
+    MinerResultType type;
+    int nWorker;
+    uint32_t nNonce;
+    uint256 hash;
+    uint64_t nHashes;
+    unsigned char header[MINER_HEADER_SIZE];
+};
+
+/**
+ * Carries results from N mining workers to one submitter thread.
+ *
+ * Every worker owns a CSPSCQueue, so together they form an MPSC channel in
+ * which producers never share a cache line, let alone a lock. Memory is
+ * bounded by nWorkers * nCapacity results; a full ring is pushed back on
+ * the worker that filled it (see CMinerReporter).
+ */
+class CMinerResultChannel
+{
+public:
+    CMinerResultChannel(int nWorkers, size_t nCapacity = DEFAULT_MINER_CHANNEL_CAPACITY);
+
+    int GetWorkerCount() const { return (int)vRings.size(); }
+
+    /** Worker nWorker only; false if its ring is full */
+    bool TryPush(int nWorker, MinerResult&& result) { return vRings[nWorker]->TryPush(std::move(result)); }
+
+    /** Submitter only: move up to nMax queued results into vResults, taking rings in turn */
+    size_t Drain(std::vector<MinerResult>& vResults, size_t nMax = SIZE_MAX);
+
+    /**
+     * Submitter only: wait until a result is queued, the channel is
+     * interrupted or nTimeoutMicros pass. Spins briefly, then backs off to
+     * sleeps so workers never have to wake the submitter.
+     */
+    bool WaitForResults(int64_t nTimeoutMicros);
+
+    void Interrupt() { fInterrupt = true; }
+    bool IsInterrupted() const { return fInterrupt; }
+
+    size_t SizeApprox() const;
+
+private:
+    std::vector<std::unique_ptr<CSPSCQueue<MinerResult>>> vRings;
+    size_t nNextRing;
+    std::atomic<bool> fInterrupt;
+};
+
+/**
+ * Worker side of a CMinerResultChannel, owned by one worker thread.
+ *
+ * Hash() is the per-nonce call: a counter increment and two 256-bit
+ * compares, with everything else out of line. Best-so-far hashes and
+ * statistics are kept locally while the ring is full and sent once it
+ * drains, so nothing is lost and the worker never stalls for them.
+ * Solutions are not droppable: when the ring is full the worker yields
+ * until the submitter catches up, which is the channel's backpressure.
+ */
+class CMinerReporter
+{
+public:
+    CMinerReporter(CMinerResultChannel& channelIn, int nWorkerIn, const arith_uint256& targetIn);
+    ~CMinerReporter();
+
+    void Hash(const unsigned char header[MINER_HEADER_SIZE], uint32_t nNonce, const uint256& hash)
+    {
+        if (++nPendingHashes >= MINER_STATS_INTERVAL)
+            ReportStats();
+        arith_uint256 bnHash = UintToArith256(hash);
+        if (bnHash <= target || bnHash < best)
+            Found(header, nNonce, hash, bnHash);
+    }
+
+    /** Send pending stats and best hash, waiting for room; call before the worker exits */
+    void Flush();
+
+    /** Times a solution had to wait for room in the ring */
+    uint64_t GetStalls() const { return nStalls; }
+
+private:
+    CMinerResultChannel& channel;
+    const int nWorker;
+    const arith_uint256 target;
+    arith_uint256 best;
+    uint64_t nPendingHashes;
+    bool fPendingBest;
+    MinerResult pendingBest;
+    uint64_t nStalls;
+
+    void Found(const unsigned char header[MINER_HEADER_SIZE], uint32_t nNonce, const uint256& hash, const arith_uint256& bnHash);
+    void ReportStats();
+    bool PushWait(MinerResult&& result);
+};
+
+#endif // LATTICE_MINERCHANNEL_H
@@ -0,0 +1,175 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "minergovernor.h"
+
+#include "latticemetrics.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+int64_t HistogramPercentileMicros(const std::vector<uint64_t>& vBefore, const std::vector<uint64_t>& vAfter, double nQuantile)
+{
+    if (vAfter.size() != METRIC_HISTOGRAM_BUCKETS + 1)
+        return -1;
+    auto delta = [&](int i) { return vAfter[i] - (vBefore.size() == vAfter.size() ? vBefore[i] : 0); };
+    uint64_t nCount = delta(METRIC_HISTOGRAM_BUCKETS);
+    if (nCount == 0)
+        return -1;
+
+    double nRank = nQuantile * nCount;
+    for (int i = 0; i < METRIC_HISTOGRAM_BUCKETS; i++) {
+        if (delta(i) >= nRank) {
+            // Bucket i holds (2^(i-1), 2^i] microseconds
+            uint64_t nBelow = i > 0 ? delta(i - 1) : 0;
+            double nLow = i > 0 ? (double)(1 << (i - 1)) : 0;
+            double nHigh = (double)(1 << i);
+            double nFrac = delta(i) > nBelow ? (nRank - nBelow) / (delta(i) - nBelow) : 1.0;
+            return (int64_t)(nLow + nFrac * (nHigh - nLow));
+        }
+    }
+    return (int64_t)1 << METRIC_HISTOGRAM_BUCKETS;
+}
+
+CMinerGovernor::CMinerGovernor(int nWorkersIn, const GovernorOptions& optionsIn) :
+    nWorkers(std::max(nWorkersIn, 1)), options(optionsIn), latency(nullptr), nLevel(nWorkers), fPressure(false),
+    nActive(nWorkers), nDutyPermille(1000), fInterrupt(false)
+{
+    RegisterMetricGauge("lattice_governor_active_workers", "Mining workers not parked by the throughput governor",
+                        [this] { return (double)nActive.load(); });
+    RegisterMetricGauge("lattice_governor_duty_cycle", "Share of time active mining workers spend hashing",
+                        [this] { return GetDutyCycle(); });
+}
+
+CMinerGovernor::~CMinerGovernor()
+{
+    Stop();
+    UnregisterMetricGauge("lattice_governor_active_workers");
+    UnregisterMetricGauge("lattice_governor_duty_cycle");
+}
+
+void CMinerGovernor::AddQueueDepthSource(std::function<size_t()> fn)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    vQueueSources.push_back(std::move(fn));
+}
+
+void CMinerGovernor::SetLatencyHistogram(const CMetricHistogram* histogram)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    latency = histogram;
+    vLastBuckets.clear();
+    if (latency) {
+        double nSum;
+        uint64_t nCount;
+        latency->Snapshot(vLastBuckets, nSum, nCount);
+    }
+}
+
+void CMinerGovernor::Start()
+{
+    if (threadControl.joinable())
+        return;
+    fInterrupt = false;
+    threadControl = std::thread(&CMinerGovernor::ThreadControl, this);
+}
+
+void CMinerGovernor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fInterrupt = true;
+    }
+    cond.notify_all();
+    if (threadControl.joinable())
+        threadControl.join();
+    std::lock_guard<std::mutex> lock(cs);
+    SetLevel(nWorkers);
+}
+
+double CMinerGovernor::GetLevel() const
+{
+    return nActive * GetDutyCycle();
+}
+
+void CMinerGovernor::SetLevel(double nLevelIn)
+{
+    nLevel = std::max(std::min(nLevelIn, (double)nWorkers), std::max(options.nMinLevel, 0.001));
+    int nActiveNew = std::min<int>(std::ceil(nLevel - 1e-9), nWorkers);
+    nDutyPermille = std::max(1, (int)std::lround(1000 * nLevel / nActiveNew));
+    if (nActiveNew > nActive) {
+        nActive = nActiveNew;
+        cond.notify_all();
+    } else {
+        nActive = nActiveNew;
+    }
+}
+
+void CMinerGovernor::Update()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    size_t nDepth = 0;
+    for (const auto& fn : vQueueSources) {
+        nDepth = std::max(nDepth, fn());
+    }
+    int64_t nP99 = -1;
+    if (latency) {
+        std::vector<uint64_t> vBuckets;
+        double nSum;
+        uint64_t nCount;
+        latency->Snapshot(vBuckets, nSum, nCount);
+        nP99 = HistogramPercentileMicros(vLastBuckets, vBuckets, 0.99);
+        vLastBuckets.swap(vBuckets);
+    }
+
+    bool fOver = nDepth > options.nMaxQueueDepth || nP99 > options.nLatencySLOMicros;
+    bool fHeadroom = nDepth <= options.nMaxQueueDepth / 2 && nP99 <= options.nLatencySLOMicros * 3 / 4;
+    if (fOver) {
+        SetLevel(nLevel / 2);
+    } else if (fHeadroom && nLevel < nWorkers) {
+        SetLevel(nLevel + 0.25);
+    }
+    if (fOver != fPressure) {
+        LogPrintf("Miner governor: %s (queue %u, p99 %s), %d of %d workers at %.0f%%\n",
+                  fOver ? "validation falling behind" : "validation caught up", nDepth,
+                  nP99 < 0 ? "n/a" : strprintf("%dus", nP99),
+                  nActive.load(), nWorkers, GetDutyCycle() * 100);
+        fPressure = fOver;
+    }
+}
+
+void CMinerGovernor::Pace(int nWorker, int64_t nBusyNanos, const std::atomic<bool>& fStop)
+{
+    int nDuty = nDutyPermille.load(std::memory_order_relaxed);
+    if (nWorker >= nActive.load(std::memory_order_relaxed)) {
+        std::unique_lock<std::mutex> lock(cs);
+        while (nWorker >= nActive && !fStop && !fInterrupt) {
+            // Timed, so fStop is noticed without the governor being told
+            cond.wait_for(lock, std::chrono::milliseconds(options.nIntervalMillis));
+        }
+        return;
+    }
+    if (nDuty < 1000) {
+        int64_t nIdleNanos = nBusyNanos * (1000 - nDuty) / nDuty;
+        std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<int64_t>(nIdleNanos, options.nIntervalMillis * 1000000)));
+    }
+}
+
+void CMinerGovernor::ThreadControl()
+{
+    RenameThread("lattice-governor");
+    std::unique_lock<std::mutex> lock(cs);
+    auto next = std::chrono::steady_clock::now();
+    while (true) {
+        // Deadline-based so wakeups meant for parked workers do not shorten the period
+        next += std::chrono::milliseconds(options.nIntervalMillis);
+        if (cond.wait_until(lock, next, [this] { return fInterrupt.load(); }))
+            break;
+        lock.unlock();
+        Update();
+        lock.lock();
+    }
+}
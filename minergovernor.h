@@ -0,0 +1,104 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_MINERGOVERNOR_H
+#define LATTICE_MINERGOVERNOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CMetricHistogram;
+
+static const int64_t DEFAULT_GOVERNOR_SLO_MICROS = 50000;
+static const size_t DEFAULT_GOVERNOR_MAX_QUEUE = 8;
+static const int64_t DEFAULT_GOVERNOR_INTERVAL_MILLIS = 250;
+
+struct GovernorOptions {
+    int64_t nLatencySLOMicros;      // p99 validation latency to stay under
+    size_t nMaxQueueDepth;          // Validation backlog that counts as falling behind
+    int64_t nIntervalMillis;        // Control period
+    double nMinLevel;               // Never throttle below this many worker-equivalents
+
+    GovernorOptions() : nLatencySLOMicros(DEFAULT_GOVERNOR_SLO_MICROS), nMaxQueueDepth(DEFAULT_GOVERNOR_MAX_QUEUE),
+                        nIntervalMillis(DEFAULT_GOVERNOR_INTERVAL_MILLIS), nMinLevel(0.1) {}
+};
+
+/**
+ * Percentile (0..1) of the observations added to a CMetricHistogram between
+ * two snapshots, interpolated within its power-of-two bucket. Returns -1 if
+ * nothing was observed.
+ */
+int64_t HistogramPercentileMicros(const std::vector<uint64_t>& vBefore, const std::vector<uint64_t>& vAfter, double nQuantile);
+
+/**
+ * Throttles mining so it coexists with validation on the same host.
+ *
+ * Every interval the control thread reads the validation queue depths and
+ * the p99 of a validation latency histogram since the last interval. The
+ * mining budget is a level in worker-equivalents, cut in half when either
+ * signal is over its limit and raised by a quarter worker per interval
+ * while both have headroom (AIMD). A level of 2.5 with four workers runs
+ * three of them at a 5/6 duty cycle and parks the fourth.
+ *
+ * Workers call Pace() between nonce batches; unless throttled that is two
+ * relaxed loads. Parked workers sleep on a condition variable, so threads
+ * are never stopped or restarted.
+ */
+class CMinerGovernor
+{
+public:
+    CMinerGovernor(int nWorkersIn, const GovernorOptions& optionsIn = GovernorOptions());
+    ~CMinerGovernor();
+
+    /** Validation backlog to watch, e.g. a PoW verifier's tip and relay queues */
+    void AddQueueDepthSource(std::function<size_t()> fn);
+    /** Validation latency to keep within the SLO, e.g. the verify_tip stage */
+    void SetLatencyHistogram(const CMetricHistogram* histogram);
+
+    void Start();
+    /** Stop adjusting and release every worker at full speed */
+    void Stop();
+
+    /**
+     * Worker side, between batches: nBusyNanos is the batch just hashed.
+     * Sleeps for the idle share of the duty cycle, or while this worker is
+     * parked, until fStop is set.
+     */
+    void Pace(int nWorker, int64_t nBusyNanos, const std::atomic<bool>& fStop);
+
+    /** One control step; called by the control thread */
+    void Update();
+
+    int GetActiveWorkers() const { return nActive; }
+    double GetDutyCycle() const { return nDutyPermille / 1000.0; }
+    double GetLevel() const;
+
+private:
+    const int nWorkers;
+    const GovernorOptions options;
+
+    std::mutex cs;
+    std::condition_variable cond;
+    std::vector<std::function<size_t()>> vQueueSources;
+    const CMetricHistogram* latency;
+    std::vector<uint64_t> vLastBuckets;
+    double nLevel;
+    bool fPressure;
+
+    std::atomic<int> nActive;
+    std::atomic<int> nDutyPermille;
+    std::atomic<bool> fInterrupt;
+    std::thread threadControl;
+
+    void SetLevel(double nLevelIn);
+    void ThreadControl();
+};
+
+#endif // LATTICE_MINERGOVERNOR_H
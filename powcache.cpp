@@ -0,0 +1,276 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "powcache.h"
+
+#include "arith_uint256.h"
+#include "compat.h"
+#include "crypto/common.h"
+#include "latticemetrics.h"
+#include "random.h"
+#include "util.h"
+
+#include <cstring>
+#include <limits>
+#include <sys/stat.h>
+
+std::unique_ptr<CPoWCache> pPoWCache;
+
+static const unsigned char POW_CACHE_MAGIC[4] = {'L', 'P', 'W', 'C'};
+
+CPoWCache::CPoWCache(const std::string& pathIn) : path(pathIn), fd(-1), k0(0), k1(0), nHits(0), nMisses(0)
+{
+}
+
+CPoWCache::~CPoWCache()
+{
+    Close();
+}
+
+void CPoWCache::WriteFileHeader(unsigned char* data) const
+{
+    memcpy(data, POW_CACHE_MAGIC, 4);
+    WriteLE32(data + 4, POW_CACHE_FORMAT_VERSION);
+    WriteLE32(data + 8, POW_CACHE_ALGO_VERSION);
+    WriteLE32(data + 12, LATTICE_MODULUS);
+    WriteLE32(data + 16, LATTICE_DIMENSION);
+    WriteLE32(data + 20, LATTICE_ROUNDS);
+    WriteLE64(data + 24, k0);
+    WriteLE64(data + 32, k1);
+    WriteLE64(data + 40, CSipHasher(0, 0).Write(data, 40).Finalize());
+}
+
+bool CPoWCache::ReadFileHeader(const unsigned char* data)
+{
+    if (memcmp(data, POW_CACHE_MAGIC, 4) != 0 || ReadLE64(data + 40) != CSipHasher(0, 0).Write(data, 40).Finalize()) {
+        LogPrintf("PoW cache: %s has a corrupt header\n", path);
+        return false;
+    }
+    if (ReadLE32(data + 4) != POW_CACHE_FORMAT_VERSION || ReadLE32(data + 8) != POW_CACHE_ALGO_VERSION ||
+        ReadLE32(data + 12) != LATTICE_MODULUS || ReadLE32(data + 16) != LATTICE_DIMENSION ||
+        ReadLE32(data + 20) != LATTICE_ROUNDS) {
+        LogPrintf("PoW cache: %s was written for a different algorithm version\n", path);
+        return false;
+    }
+    k0 = ReadLE64(data + 24);
+    k1 = ReadLE64(data + 32);
+    return true;
+}
+
+/** SHAKE128(LE32 nPoWVersion || v1/v2 matrix seed || header); the seed is zero for per-block XOF matrices */
+static uint256 PoWCacheHeaderDigest(const unsigned char* header, size_t nHeaderLen, int nPoWVersion)
+{
+    unsigned char ver[4];
+    WriteLE32(ver, nPoWVersion);
+    uint256 seed;
+    if (nPoWVersion < LATTICE_POW_VERSION_XOF && lattice_initialized.load(std::memory_order_acquire))
+        seed = lattice_matrix_seed;
+
+    uint256 digest;
+    CSHAKE128().Write(ver, sizeof(ver)).Write(seed.begin(), 32).Write(header, nHeaderLen).Squeeze(digest.begin(), 32);
+    return digest;
+}
+
+uint32_t CPoWCache::RecordChecksum(const unsigned char* record) const
+{
+    return (uint32_t)CSipHasher(k0, k1).Write(record, POW_CACHE_RECORD_SIZE - 4).Finalize();
+}
+
+bool CPoWCache::Reset()
+{
+    k0 = GetRand(std::numeric_limits<uint64_t>::max());
+    k1 = GetRand(std::numeric_limits<uint64_t>::max());
+    mapVerified.clear();
+
+    unsigned char header[POW_CACHE_FILE_HEADER_SIZE];
+    WriteFileHeader(header);
+    if (ftruncate(fd, 0) != 0 || pwrite(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) || fdatasync(fd) != 0) {
+        LogPrintf("PoW cache: unable to initialize %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool CPoWCache::Open()
+{
+    std::lock_guard<std::mutex> lock(cs);
+
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        LogPrintf("PoW cache: unable to open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        Close();
+        return false;
+    }
+    size_t nFileSize = st.st_size;
+    if (nFileSize < POW_CACHE_FILE_HEADER_SIZE) {
+        if (!Reset()) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void* map = mmap(nullptr, nFileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        LogPrintf("PoW cache: mmap of %s failed: %s\n", path, strerror(errno));
+        Close();
+        return false;
+    }
+    madvise(map, nFileSize, MADV_SEQUENTIAL);
+    const unsigned char* data = static_cast<const unsigned char*>(map);
+
+    bool fHeaderValid = ReadFileHeader(data);
+    size_t nValidSize = POW_CACHE_FILE_HEADER_SIZE;
+    if (fHeaderValid) {
+        size_t nRecords = (nFileSize - POW_CACHE_FILE_HEADER_SIZE) / POW_CACHE_RECORD_SIZE;
+        mapVerified.reserve(nRecords);
+        for (size_t i = 0; i < nRecords; i++) {
+            const unsigned char* record = data + nValidSize;
+            if (ReadLE32(record + 72) != RecordChecksum(record))
+                break;
+            Entry entry;
+            memcpy(entry.hashBlock.begin(), record, 32);
+            memcpy(entry.headerDigest.begin(), record + 32, 32);
+            entry.nBits = ReadLE32(record + 68);
+            mapVerified[SipHashUint256(k0, k1, entry.headerDigest)] = entry;
+            nValidSize += POW_CACHE_RECORD_SIZE;
+        }
+    }
+    munmap(map, nFileSize);
+
+    if (!fHeaderValid) {
+        if (!Reset()) {
+            Close();
+            return false;
+        }
+    } else if (nValidSize != nFileSize) {
+        // Drop a torn or corrupt tail so new records stay aligned
+        LogPrintf("PoW cache: truncating %u trailing bytes of %s\n", nFileSize - nValidSize, path);
+        if (ftruncate(fd, nValidSize) != 0) {
+            Close();
+            return false;
+        }
+    }
+
+    LogPrintf("PoW cache: loaded %u verified headers from %s\n", mapVerified.size(), path);
+    return true;
+}
+
+void CPoWCache::Close()
+{
+    if (fd >= 0) {
+        fdatasync(fd);
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool CPoWCache::Flush()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return fd < 0 || fdatasync(fd) == 0;
+}
+
+size_t CPoWCache::Size()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return mapVerified.size();
+}
+
+const CPoWCache::Entry* CPoWCache::Find(const uint256& headerDigest) const
+{
+    auto it = mapVerified.find(SipHashUint256(k0, k1, headerDigest));
+    if (it == mapVerified.end() || it->second.headerDigest != headerDigest)
+        return nullptr;
+    return &it->second;
+}
+
+bool CPoWCache::GetVerified(const unsigned char* header, size_t nHeaderLen, uint32_t nBits, int nPoWVersion, uint256& hashBlock)
+{
+    uint256 headerDigest = PoWCacheHeaderDigest(header, nHeaderLen, nPoWVersion);
+
+    std::lock_guard<std::mutex> lock(cs);
+    const Entry* entry = Find(headerDigest);
+    if (entry == nullptr || entry->nBits != nBits) {
+        nMisses++;
+        return false;
+    }
+    nHits++;
+    hashBlock = entry->hashBlock;
+    return true;
+}
+
+void CPoWCache::AddVerified(const uint256& hashBlock, const unsigned char* header, size_t nHeaderLen, uint32_t nBits, int nPoWVersion)
+{
+    Entry entry;
+    entry.headerDigest = PoWCacheHeaderDigest(header, nHeaderLen, nPoWVersion);
+    entry.hashBlock = hashBlock;
+    entry.nBits = nBits;
+
+    unsigned char record[POW_CACHE_RECORD_SIZE];
+    memcpy(record, hashBlock.begin(), 32);
+    memcpy(record + 32, entry.headerDigest.begin(), 32);
+    WriteLE32(record + 64, nPoWVersion);
+    WriteLE32(record + 68, entry.nBits);
+    WriteLE32(record + 72, RecordChecksum(record));
+
+    std::lock_guard<std::mutex> lock(cs);
+    // A SipHash bucket collision with another digest just leaves this header uncached
+    if (!mapVerified.insert(std::make_pair(SipHashUint256(k0, k1, entry.headerDigest), entry)).second)
+        return;
+    if (fd >= 0 && write(fd, record, sizeof(record)) != (ssize_t)sizeof(record)) {
+        LogPrintf("PoW cache: write to %s failed, disabling persistence: %s\n", path, strerror(errno));
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool CheckLatticePoWCached(CPoWCache* cache, const unsigned char* header, size_t nHeaderLen, uint32_t nBits, int nPoWVersion,
+                           const std::function<const LatticeRoundTable&()>& fnTable, uint256& hashRet)
+{
+    if (cache && cache->GetVerified(header, nHeaderLen, nBits, nPoWVersion, hashRet))
+        return true;
+
+    const LatticeRoundTable& table = fnTable();
+    int64_t nStart = MetricNanos();
+    hashRet = HashLatticePOW(header, header + nHeaderLen, table);
+    g_lattice_metrics.hashLatency.Observe(MetricNanos() - nStart);
+    g_lattice_metrics.hashes.Add();
+
+    bool fNegative;
+    bool fOverflow;
+    arith_uint256 bnTarget;
+    bnTarget.SetCompact(nBits, &fNegative, &fOverflow);
+    if (fNegative || bnTarget == 0 || fOverflow || UintToArith256(hashRet) > bnTarget)
+        return false;
+
+    if (cache)
+        cache->AddVerified(hashRet, header, nHeaderLen, nBits, nPoWVersion);
+    return true;
+}
+
+bool StartPoWCache(const std::string& strDataDir, bool fEnable)
+{
+    pPoWCache.reset();
+    if (!fEnable)
+        return true;
+    std::unique_ptr<CPoWCache> cache(new CPoWCache(strDataDir + "/" + DEFAULT_POW_CACHE_FILE));
+    if (!cache->Open())
+        return false;
+    pPoWCache = std::move(cache);
+    return true;
+}
+
+void StopPoWCache()
+{
+    if (!pPoWCache)
+        return;
+    LogPrintf("PoW cache: %u hits, %u misses\n", pPoWCache->GetHits(), pPoWCache->GetMisses());
+    pPoWCache.reset();
+}
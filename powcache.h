@@ -0,0 +1,111 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_POWCACHE_H
+#define LATTICE_POWCACHE_H
+
+#include "hash.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+static const bool DEFAULT_POW_CACHE = true;
+static const char* const DEFAULT_POW_CACHE_FILE = "powcache.dat";
+
+/**
+ * Bump whenever HashLatticePOW output changes for any existing
+ * LATTICE_POW_VERSION_*; older cache files are then discarded on open.
+ */
+static const uint32_t POW_CACHE_ALGO_VERSION = 2;
+static const uint32_t POW_CACHE_FORMAT_VERSION = 2;
+static const size_t POW_CACHE_FILE_HEADER_SIZE = 48;
+static const size_t POW_CACHE_RECORD_SIZE = 76;
+
+/**
+ * Append-only on-disk record of headers whose LATTICE-PoW was already
+ * checked against their nBits target.
+ *
+ * File layout: a 48-byte header (magic, format and algorithm version,
+ * lattice parameters, SipHash key, checksum) followed by 76-byte records of
+ * block hash, header digest, PoW version, nBits and a record checksum.
+ * The file is mmap'd and scanned once on open; a torn or corrupt tail is
+ * truncated and a header mismatch resets the whole file.
+ *
+ * The header digest is SHAKE128 over the PoW version, the v1/v2 matrix seed
+ * and the header, so a header can be looked up before its hash is known and
+ * an entry never answers for another algorithm version or legacy matrix. The
+ * in-memory index buckets digests by a per-file SipHash key and a hit
+ * compares the full 256-bit digest.
+ */
+class CPoWCache
+{
+public:
+    explicit CPoWCache(const std::string& pathIn);
+    ~CPoWCache();
+
+    /** Open (or create) the file and load all valid records */
+    bool Open();
+    void Close();
+    bool Flush();
+
+    /** True if this header was already verified against nBits under nPoWVersion; hashBlock is set to its recorded hash */
+    bool GetVerified(const unsigned char* header, size_t nHeaderLen, uint32_t nBits, int nPoWVersion, uint256& hashBlock);
+    /** Record a successful PoW check */
+    void AddVerified(const uint256& hashBlock, const unsigned char* header, size_t nHeaderLen, uint32_t nBits, int nPoWVersion);
+
+    size_t Size();
+    uint64_t GetHits() const { return nHits; }
+    uint64_t GetMisses() const { return nMisses; }
+
+private:
+    struct Entry {
+        uint256 headerDigest;
+        uint256 hashBlock;
+        uint32_t nBits;
+    };
+
+    const std::string path;
+    int fd;
+    uint64_t k0, k1;
+
+    std::mutex cs;
+    std::unordered_map<uint64_t, Entry> mapVerified;    // By keyed SipHash of the header digest
+    uint64_t nHits;
+    uint64_t nMisses;
+
+    bool Reset();
+    bool ReadFileHeader(const unsigned char* data);
+    void WriteFileHeader(unsigned char* data) const;
+    uint32_t RecordChecksum(const unsigned char* record) const;
+    /** Entry for digest, or null; requires cs */
+    const Entry* Find(const uint256& headerDigest) const;
+};
+
+/**
+ * Check a header's LATTICE-PoW against nBits, skipping the lattice rounds
+ * when cache already holds a matching verified entry, and recording the
+ * header when it passes. hashRet is the LATTICE-PoW hash either way.
+ * fnTable is only called when the header has to be hashed, so a hit does
+ * not build a round table either; the table it returns must be for
+ * nPoWVersion. cache may be null.
+ */
+bool CheckLatticePoWCached(CPoWCache* cache, const unsigned char* header, size_t nHeaderLen, uint32_t nBits, int nPoWVersion,
+                           const std::function<const LatticeRoundTable&()>& fnTable, uint256& hashRet);
+
+/** Cache consulted by the reindex pipeline and CPoWVerifier; null when disabled */
+extern std::unique_ptr<CPoWCache> pPoWCache;
+
+/**
+ * Open DEFAULT_POW_CACHE_FILE in strDataDir as pPoWCache, unless fEnable is
+ * false. For node init, before the reindex pipeline or CPoWVerifier starts;
+ * until then pPoWCache is null and every header is hashed.
+ */
+bool StartPoWCache(const std::string& strDataDir, bool fEnable = DEFAULT_POW_CACHE);
+/** Sync and close pPoWCache; for node shutdown, after verification has stopped */
+void StopPoWCache();
+
+#endif // LATTICE_POWCACHE_H
@@ -0,0 +1,181 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "powverify.h"
+
+#include "latticemetrics.h"
+#include "latticeplacement.h"
+#include "powcache.h"
+#include "util.h"
+
+#include <cstring>
+
+static const char* const POW_PRIORITY_NAMES[NUM_POW_PRIORITIES] = {"tip", "relay", "ibd", "reindex"};
+
+static PoWVerifyResult CancelledResult()
+{
+    PoWVerifyResult result;
+    result.fValid = false;
+    result.fCancelled = true;
+    return result;
+}
+
+CPoWVerifier::CPoWVerifier(int nThreads) : nNextWorker(0), fInterrupt(false)
+{
+    // Workers build v1/v2 tables concurrently; the matrix must not depend on which one is first
+    InitializeLatticeMatrix(uint256S(LATTICE_MATRIX_DEFAULT_SEED));
+    for (int p = 0; p < NUM_POW_PRIORITIES; p++) {
+        nQueued[p] = 0;
+        latency[p] = &GetStageHistogram(std::string("verify_") + POW_PRIORITY_NAMES[p]);
+        RegisterMetricGauge(std::string("lattice_pow_verify_") + POW_PRIORITY_NAMES[p] + "_queued",
+                            "PoW verification requests waiting in this priority class",
+                            [this, p] { return (double)nQueued[p].load(); });
+    }
+    for (int i = 0; i < std::max(nThreads, 1); i++) {
+        vWorkers.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < vWorkers.size(); i++) {
+        vWorkers[i]->thread = std::thread(&CPoWVerifier::ThreadWorker, this, i);
+    }
+}
+
+CPoWVerifier::~CPoWVerifier()
+{
+    for (int p = 0; p < NUM_POW_PRIORITIES; p++) {
+        UnregisterMetricGauge(std::string("lattice_pow_verify_") + POW_PRIORITY_NAMES[p] + "_queued");
+    }
+    {
+        std::lock_guard<std::mutex> lock(cs_idle);
+        fInterrupt = true;
+    }
+    condIdle.notify_all();
+    for (const std::unique_ptr<Worker>& worker : vWorkers) {
+        worker->thread.join();
+    }
+    // Nobody is left to hash what is still queued
+    for (int p = 0; p < NUM_POW_PRIORITIES; p++) {
+        CancelQueued((PoWPriority)p);
+    }
+}
+
+std::future<PoWVerifyResult> CPoWVerifier::Submit(const unsigned char header[POW_VERIFY_HEADER_SIZE], uint32_t nBits,
+                                                  int nPoWVersion, PoWPriority priority, const PoWCancelToken& cancel)
+{
+    RequestPtr request(new Request());
+    memcpy(request->header, header, POW_VERIFY_HEADER_SIZE);
+    memcpy(request->hashPrevBlock.begin(), header + 4, 32);
+    request->nBits = nBits;
+    request->nPoWVersion = nPoWVersion;
+    request->priority = priority;
+    request->cancel = cancel;
+    request->nSubmitNanos = MetricNanos();
+    std::future<PoWVerifyResult> future = request->promise.get_future();
+
+    Worker& worker = *vWorkers[nNextWorker++ % vWorkers.size()];
+    {
+        std::lock_guard<std::mutex> lock(worker.cs);
+        worker.queues[priority].push_back(std::move(request));
+        nQueued[priority]++;
+    }
+    {
+        // Taking the lock orders this push before a worker's idle check
+        std::lock_guard<std::mutex> lock(cs_idle);
+    }
+    condIdle.notify_one();
+    return future;
+}
+
+void CPoWVerifier::CancelQueued(PoWPriority priority)
+{
+    std::vector<RequestPtr> vCancelled;
+    for (const std::unique_ptr<Worker>& worker : vWorkers) {
+        std::lock_guard<std::mutex> lock(worker->cs);
+        std::deque<RequestPtr>& queue = worker->queues[priority];
+        nQueued[priority] -= queue.size();
+        for (RequestPtr& request : queue) {
+            vCancelled.push_back(std::move(request));
+        }
+        queue.clear();
+    }
+    for (RequestPtr& request : vCancelled) {
+        request->promise.set_value(CancelledResult());
+    }
+}
+
+bool CPoWVerifier::TryTake(size_t nSelf, RequestPtr& request)
+{
+    for (int p = 0; p < NUM_POW_PRIORITIES; p++) {
+        if (nQueued[p] == 0)
+            continue;
+        // Own queue from the front, others stolen from the back
+        for (size_t i = 0; i < vWorkers.size(); i++) {
+            Worker& worker = *vWorkers[(nSelf + i) % vWorkers.size()];
+            std::lock_guard<std::mutex> lock(worker.cs);
+            std::deque<RequestPtr>& queue = worker.queues[p];
+            if (queue.empty())
+                continue;
+            if (i == 0) {
+                request = std::move(queue.front());
+                queue.pop_front();
+            } else {
+                request = std::move(queue.back());
+                queue.pop_back();
+            }
+            nQueued[p]--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CPoWVerifier::Process(RequestPtr& request, LatticeRoundTable& table, CWorkerPlacement& placement)
+{
+    if (request->cancel && *request->cancel) {
+        request->promise.set_value(CancelledResult());
+        return;
+    }
+
+    auto fnTable = [&]() -> const LatticeRoundTable& {
+        if (table.matrix == nullptr || table.hashPrevBlock != request->hashPrevBlock || table.nVersion != request->nPoWVersion) {
+            BuildLatticeRoundTable(request->hashPrevBlock, request->nPoWVersion, table);
+            placement.LocalizeRoundTable(table);
+        }
+        return table;
+    };
+
+    PoWVerifyResult result;
+    result.fCancelled = false;
+    result.fValid = CheckLatticePoWCached(pPoWCache.get(), request->header, POW_VERIFY_HEADER_SIZE, request->nBits,
+                                          request->nPoWVersion, fnTable, result.hash);
+
+    latency[request->priority]->Observe(MetricNanos() - request->nSubmitNanos);
+    request->promise.set_value(result);
+}
+
+void CPoWVerifier::ThreadWorker(size_t nSelf)
+{
+    RenameThread("lattice-powverify");
+    CWorkerPlacement placement;
+    LatticeRoundTable table;
+    table.matrix = nullptr;
+
+    while (!fInterrupt) {
+        RequestPtr request;
+        if (TryTake(nSelf, request)) {
+            Process(request, table, placement);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(cs_idle);
+        condIdle.wait(lock, [this] {
+            if (fInterrupt)
+                return true;
+            for (int p = 0; p < NUM_POW_PRIORITIES; p++) {
+                if (nQueued[p] > 0)
+                    return true;
+            }
+            return false;
+        });
+    }
+}
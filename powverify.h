@@ -0,0 +1,111 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_POWVERIFY_H
+#define LATTICE_POWVERIFY_H
+
+#include "hash.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class CMetricHistogram;
+class CWorkerPlacement;
+
+static const int DEFAULT_POW_VERIFY_THREADS = 4;
+static const size_t POW_VERIFY_HEADER_SIZE = 80;
+
+/** Verification classes, most urgent first */
+enum PoWPriority {
+    POW_PRIORITY_TIP,       // Candidate new tip; gates block relay
+    POW_PRIORITY_RELAY,     // Headers and blocks announced by peers
+    POW_PRIORITY_IBD,       // Initial block download
+    POW_PRIORITY_REINDEX,   // Local replay
+    NUM_POW_PRIORITIES
+};
+
+struct PoWVerifyResult {
+    uint256 hash;           // LATTICE-PoW hash of the header
+    bool fValid;            // hash meets the nBits target
+    bool fCancelled;        // Dropped before hashing; hash and fValid are unset
+};
+
+/**
+ * Shared flag for cancelling queued requests, e.g. everything fetched from a
+ * peer that disconnected or headers on a branch that lost. Requests already
+ * being hashed run to completion.
+ */
+typedef std::shared_ptr<std::atomic<bool>> PoWCancelToken;
+
+inline PoWCancelToken MakePoWCancelToken() { return std::make_shared<std::atomic<bool>>(false); }
+
+/**
+ * Asynchronous LATTICE-PoW verification with priority classes.
+ *
+ * Each worker owns a FIFO per priority class and requests are spread over
+ * them round-robin. An idle worker serves the most urgent non-empty class,
+ * taking from its own queue first and stealing from the back of the others,
+ * so a new tip header waits at most for the hashes already in flight while
+ * IBD and reindex batches keep every core busy.
+ */
+class CPoWVerifier
+{
+public:
+    explicit CPoWVerifier(int nThreads = DEFAULT_POW_VERIFY_THREADS);
+    ~CPoWVerifier();
+
+    /**
+     * Queue one 80-byte header, hashed over the round table for the
+     * hashPrevBlock it carries; the future is ready once it was hashed or
+     * cancelled.
+     */
+    std::future<PoWVerifyResult> Submit(const unsigned char header[POW_VERIFY_HEADER_SIZE], uint32_t nBits, int nPoWVersion,
+                                        PoWPriority priority, const PoWCancelToken& cancel = PoWCancelToken());
+
+    /** Cancel every request of a class that is still queued */
+    void CancelQueued(PoWPriority priority);
+
+    size_t GetQueued(PoWPriority priority) const { return nQueued[priority]; }
+    int GetThreadCount() const { return (int)vWorkers.size(); }
+
+private:
+    struct Request {
+        unsigned char header[POW_VERIFY_HEADER_SIZE];
+        uint256 hashPrevBlock;                  // From header
+        uint32_t nBits;
+        int nPoWVersion;
+        PoWPriority priority;
+        PoWCancelToken cancel;
+        int64_t nSubmitNanos;
+        std::promise<PoWVerifyResult> promise;
+    };
+    typedef std::unique_ptr<Request> RequestPtr;
+
+    struct Worker {
+        std::mutex cs;
+        std::deque<RequestPtr> queues[NUM_POW_PRIORITIES];
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> vWorkers;
+    std::atomic<size_t> nQueued[NUM_POW_PRIORITIES];
+    std::atomic<size_t> nNextWorker;
+    CMetricHistogram* latency[NUM_POW_PRIORITIES];
+
+    std::mutex cs_idle;
+    std::condition_variable condIdle;
+    std::atomic<bool> fInterrupt;
+
+    bool TryTake(size_t nSelf, RequestPtr& request);
+    void Process(RequestPtr& request, LatticeRoundTable& table, CWorkerPlacement& placement);
+    void ThreadWorker(size_t nSelf);
+};
+
+#endif // LATTICE_POWVERIFY_H
@@ -0,0 +1,305 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "reindex.h"
+
+#include "clientversion.h"
+#include "consensus/consensus.h"
+#include "consensus/merkle.h"
+#include "crypto/common.h"
+#include "latticemetrics.h"
+#include "latticeplacement.h"
+#include "latticeprofile.h"
+#include "powcache.h"
+#include "primitives/block.h"
+#include "streams.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+static const char* const REINDEX_STAGE_NAMES[NUM_REINDEX_STAGES] = {"read", "parse", "pow", "merkle"};
+
+static int64_t PipelineMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Spin briefly, then yield, then sleep while a queue is empty or full */
+static void Backoff(int& nSpins)
+{
+    if (++nSpins < 64)
+        return;
+    if (nSpins < 128) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+CReindexPipeline::CReindexPipeline(const ReindexPipelineOptions& optionsIn, const unsigned char pchMessageStartIn[4]) :
+    options(optionsIn), fInterrupt(false), nNextFile(0), nElapsed(0)
+{
+    memcpy(pchMessageStart, pchMessageStartIn, 4);
+    // Seeded here rather than by whichever block a PoW thread hashes first
+    InitializeLatticeMatrix(uint256S(LATTICE_MATRIX_DEFAULT_SEED));
+    for (int stage = 0; stage < NUM_REINDEX_STAGES; stage++) {
+        queues[stage].reset(new CLockFreeQueue<Item>(options.nQueueDepth));
+        stats[stage].nThreads = std::max(options.nThreads[stage], 1);
+        nActive[stage] = 0;
+        stageTimings[stage] = &GetStageHistogram(std::string("reindex_") + REINDEX_STAGE_NAMES[stage]);
+    }
+}
+
+bool CReindexPipeline::Pop(ReindexStage upstream, Item& item)
+{
+    int nSpins = 0;
+    while (!queues[upstream]->TryPop(item)) {
+        if (fInterrupt)
+            return false;
+        if (nActive[upstream].load(std::memory_order_acquire) == 0) {
+            // Upstream finished; anything it pushed is visible now
+            return queues[upstream]->TryPop(item);
+        }
+        Backoff(nSpins);
+    }
+    return true;
+}
+
+void CReindexPipeline::Push(ReindexStage stage, Item&& item)
+{
+    int nSpins = 0;
+    while (!queues[stage]->TryPush(std::move(item))) {
+        if (fInterrupt)
+            return;
+        Backoff(nSpins);
+    }
+}
+
+void CReindexPipeline::ReadFile(int nFile)
+{
+    FILE* file = fopen(vFiles[nFile].c_str(), "rb");
+    if (!file) {
+        LogPrintf("Reindex: unable to open %s\n", vFiles[nFile]);
+        stats[REINDEX_STAGE_READ].nErrors++;
+        return;
+    }
+    std::vector<char> vBuffer(1 << 20);
+    setvbuf(file, vBuffer.data(), _IOFBF, vBuffer.size());
+
+    unsigned char window[4] = {};
+    uint64_t nPos = 0;
+    int c;
+    while (!fInterrupt && (c = fgetc(file)) != EOF) {
+        // Scan for the network magic that precedes every block record
+        nPos++;
+        memmove(window, window + 1, 3);
+        window[3] = (unsigned char)c;
+        if (nPos < 4 || memcmp(window, pchMessageStart, 4) != 0)
+            continue;
+
+        int64_t nStart = PipelineMicros();
+        unsigned char size[4];
+        if (fread(size, 1, 4, file) != 4)
+            break;
+        nPos += 4;
+        uint32_t nSize = ReadLE32(size);
+        if (nSize < 80 || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+            continue;
+
+        Item item(new ReindexBlock());
+        item->nFile = nFile;
+        item->nPos = nPos;
+        item->fValid = true;
+        item->raw.resize(nSize);
+        if (fread(item->raw.data(), 1, nSize, file) != nSize) {
+            stats[REINDEX_STAGE_READ].nErrors++;
+            break;
+        }
+        nPos += nSize;
+
+        stats[REINDEX_STAGE_READ].nItems++;
+        stats[REINDEX_STAGE_READ].nBytes += nSize;
+        int64_t nBusy = PipelineMicros() - nStart;
+        stats[REINDEX_STAGE_READ].nBusyMicros += nBusy;
+        stageTimings[REINDEX_STAGE_READ]->Observe(nBusy * 1000);
+        Push(REINDEX_STAGE_READ, std::move(item));
+    }
+    fclose(file);
+}
+
+void CReindexPipeline::ThreadRead()
+{
+    RenameThread("lattice-reindex-read");
+    size_t nFile;
+    while (!fInterrupt && (nFile = nNextFile++) < vFiles.size()) {
+        ReadFile(nFile);
+    }
+    nActive[REINDEX_STAGE_READ]--;
+}
+
+void CReindexPipeline::ThreadParse()
+{
+    RenameThread("lattice-reindex-parse");
+    ReindexStageStats& stat = stats[REINDEX_STAGE_PARSE];
+    Item item;
+    while (Pop(REINDEX_STAGE_READ, item)) {
+        int64_t nStart = PipelineMicros();
+        try {
+            CDataStream ss(item->raw.begin(), item->raw.end(), SER_DISK, CLIENT_VERSION);
+            item->block = std::make_shared<CBlock>();
+            ss >> *item->block;
+        } catch (const std::exception& e) {
+            LogPrintf("Reindex: deserialize error in file %d at %u: %s\n", item->nFile, item->nPos, e.what());
+            stat.nErrors++;
+            continue;
+        }
+        stat.nItems++;
+        stat.nBytes += item->raw.size();
+        int64_t nBusy = PipelineMicros() - nStart;
+        stat.nBusyMicros += nBusy;
+        stageTimings[REINDEX_STAGE_PARSE]->Observe(nBusy * 1000);
+        Push(REINDEX_STAGE_PARSE, std::move(item));
+    }
+    nActive[REINDEX_STAGE_PARSE]--;
+}
+
+void CReindexPipeline::ThreadPoW()
+{
+    RenameThread("lattice-reindex-pow");
+    CWorkerPlacement placement;
+    ReindexStageStats& stat = stats[REINDEX_STAGE_POW];
+    std::vector<Item> vBatch;
+    vBatch.reserve(options.nPoWBatchSize);
+    LatticeRoundTable table;
+    table.matrix = nullptr;
+
+    while (true) {
+        // Block for the first item, then take whatever else is ready
+        Item item;
+        if (!Pop(REINDEX_STAGE_PARSE, item))
+            break;
+        vBatch.push_back(std::move(item));
+        while (vBatch.size() < options.nPoWBatchSize && queues[REINDEX_STAGE_PARSE]->TryPop(item)) {
+            vBatch.push_back(std::move(item));
+        }
+
+        int64_t nStart = PipelineMicros();
+        {
+            CPerfScope scope("reindex_pow", vBatch.size());
+            for (Item& block : vBatch) {
+                const uint256& hashPrevBlock = block->block->hashPrevBlock;
+                auto fnTable = [&]() -> const LatticeRoundTable& {
+                    if (table.matrix == nullptr || table.hashPrevBlock != hashPrevBlock) {
+                        BuildLatticeRoundTable(hashPrevBlock, options.nPoWVersion, table);
+                        placement.LocalizeRoundTable(table);
+                    }
+                    return table;
+                };
+                const unsigned char* header = reinterpret_cast<const unsigned char*>(block->raw.data());
+                if (!CheckLatticePoWCached(pPoWCache.get(), header, 80, block->block->nBits, options.nPoWVersion, fnTable, block->hash)) {
+                    block->fValid = false;
+                    block->strReject = "high-hash";
+                    stat.nErrors++;
+                }
+            }
+        }
+        stat.nItems += vBatch.size();
+        stat.nBytes += 80 * vBatch.size();
+        int64_t nBusy = PipelineMicros() - nStart;
+        stat.nBusyMicros += nBusy;
+        stageTimings[REINDEX_STAGE_POW]->Observe(nBusy * 1000 / vBatch.size());
+
+        for (Item& block : vBatch) {
+            Push(REINDEX_STAGE_POW, std::move(block));
+        }
+        vBatch.clear();
+    }
+    nActive[REINDEX_STAGE_POW]--;
+}
+
+void CReindexPipeline::ThreadMerkle()
+{
+    RenameThread("lattice-reindex-merkle");
+    ReindexStageStats& stat = stats[REINDEX_STAGE_MERKLE];
+    Item item;
+    while (Pop(REINDEX_STAGE_POW, item)) {
+        int64_t nStart = PipelineMicros();
+        if (item->fValid) {
+            // Leaves are txids, as in validation; serializing would include witnesses
+            const CBlock& block = *item->block;
+            bool fMutated = false;
+            if (BlockMerkleRoot(block, &fMutated) != block.hashMerkleRoot || fMutated) {
+                item->fValid = false;
+                item->strReject = fMutated ? "bad-txns-duplicate" : "bad-txnmrklroot";
+                stat.nErrors++;
+            }
+            stat.nItems++;
+            stat.nBytes += item->raw.size();
+        }
+        int64_t nBusy = PipelineMicros() - nStart;
+        stat.nBusyMicros += nBusy;
+        stageTimings[REINDEX_STAGE_MERKLE]->Observe(nBusy * 1000);
+        Push(REINDEX_STAGE_MERKLE, std::move(item));
+    }
+    nActive[REINDEX_STAGE_MERKLE]--;
+}
+
+void CReindexPipeline::Run(const std::vector<std::string>& vFilesIn, const BlockHandler& handler)
+{
+    vFiles = vFilesIn;
+    nNextFile = 0;
+    int64_t nStart = PipelineMicros();
+    for (int stage = 0; stage < NUM_REINDEX_STAGES; stage++) {
+        CLockFreeQueue<Item>* queue = queues[stage].get();
+        RegisterMetricGauge(std::string("lattice_reindex_") + REINDEX_STAGE_NAMES[stage] + "_queue_depth",
+                            "Blocks waiting in the reindex queue after this stage",
+                            [queue] { return (double)queue->SizeApprox(); });
+    }
+
+    std::vector<std::thread> vThreads;
+    for (int stage = 0; stage < NUM_REINDEX_STAGES; stage++) {
+        nActive[stage] = stats[stage].nThreads;
+    }
+    for (int i = 0; i < stats[REINDEX_STAGE_READ].nThreads; i++)
+        vThreads.emplace_back(&CReindexPipeline::ThreadRead, this);
+    for (int i = 0; i < stats[REINDEX_STAGE_PARSE].nThreads; i++)
+        vThreads.emplace_back(&CReindexPipeline::ThreadParse, this);
+    for (int i = 0; i < stats[REINDEX_STAGE_POW].nThreads; i++)
+        vThreads.emplace_back(&CReindexPipeline::ThreadPoW, this);
+    for (int i = 0; i < stats[REINDEX_STAGE_MERKLE].nThreads; i++)
+        vThreads.emplace_back(&CReindexPipeline::ThreadMerkle, this);
+
+    // The calling thread is the sink, so the handler never runs concurrently
+    Item item;
+    while (Pop(REINDEX_STAGE_MERKLE, item)) {
+        handler(*item);
+    }
+
+    for (std::thread& thread : vThreads) {
+        thread.join();
+    }
+    for (int stage = 0; stage < NUM_REINDEX_STAGES; stage++) {
+        UnregisterMetricGauge(std::string("lattice_reindex_") + REINDEX_STAGE_NAMES[stage] + "_queue_depth");
+    }
+    nElapsed = (PipelineMicros() - nStart) / 1e6;
+    LogPrintf("%s", FormatStats());
+}
+
+std::string CReindexPipeline::FormatStats() const
+{
+    std::string str;
+    for (int stage = 0; stage < NUM_REINDEX_STAGES; stage++) {
+        const ReindexStageStats& stat = stats[stage];
+        double nBusy = stat.nBusyMicros / 1e6;
+        str += strprintf("Reindex %-6s: %u threads, %u blocks, %u errors, %.1f blocks/s, %.2f MB/s, %.0f%% busy\n",
+                         REINDEX_STAGE_NAMES[stage], stat.nThreads, stat.nItems.load(), stat.nErrors.load(),
+                         nElapsed > 0 ? stat.nItems / nElapsed : 0.0, nElapsed > 0 ? stat.nBytes / nElapsed / 1e6 : 0.0,
+                         nElapsed > 0 ? 100.0 * nBusy / (nElapsed * stat.nThreads) : 0.0);
+    }
+    return str;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_REINDEX_H
+#define LATTICE_REINDEX_H
+
+#include "hash.h"
+#include "lockfreequeue.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CBlock;
+class CMetricHistogram;
+
+static const int DEFAULT_REINDEX_READ_THREADS = 1;
+static const int DEFAULT_REINDEX_PARSE_THREADS = 2;
+static const int DEFAULT_REINDEX_POW_THREADS = 4;
+static const int DEFAULT_REINDEX_MERKLE_THREADS = 2;
+static const size_t DEFAULT_REINDEX_QUEUE_DEPTH = 256;
+static const size_t DEFAULT_REINDEX_POW_BATCH = 16;
+
+enum ReindexStage {
+    REINDEX_STAGE_READ,
+    REINDEX_STAGE_PARSE,
+    REINDEX_STAGE_POW,
+    REINDEX_STAGE_MERKLE,
+    NUM_REINDEX_STAGES
+};
+
+struct ReindexPipelineOptions {
+    int nThreads[NUM_REINDEX_STAGES];
+    size_t nQueueDepth;     // Slots in each inter-stage queue
+    size_t nPoWBatchSize;   // Blocks a PoW verifier takes per queue visit
+    int nPoWVersion;
+
+    ReindexPipelineOptions() : nQueueDepth(DEFAULT_REINDEX_QUEUE_DEPTH), nPoWBatchSize(DEFAULT_REINDEX_POW_BATCH),
+                               nPoWVersion(LATTICE_POW_VERSION_SINGLE)
+    {
+        nThreads[REINDEX_STAGE_READ] = DEFAULT_REINDEX_READ_THREADS;
+        nThreads[REINDEX_STAGE_PARSE] = DEFAULT_REINDEX_PARSE_THREADS;
+        nThreads[REINDEX_STAGE_POW] = DEFAULT_REINDEX_POW_THREADS;
+        nThreads[REINDEX_STAGE_MERKLE] = DEFAULT_REINDEX_MERKLE_THREADS;
+    }
+};
+
+/** One block travelling through the pipeline */
+struct ReindexBlock {
+    int nFile;
+    uint64_t nPos;                  // Offset of the serialized block in its file
+    std::vector<char> raw;          // Serialized block; the header is the first 80 bytes
+    std::shared_ptr<CBlock> block;
+    uint256 hash;                   // LATTICE-PoW hash of the header
+    bool fValid;
+    std::string strReject;
+};
+
+struct ReindexStageStats {
+    std::atomic<uint64_t> nItems;
+    std::atomic<uint64_t> nBytes;
+    std::atomic<uint64_t> nBusyMicros;
+    std::atomic<uint64_t> nErrors;
+    int nThreads;
+
+    ReindexStageStats() : nItems(0), nBytes(0), nBusyMicros(0), nErrors(0), nThreads(0) {}
+};
+
+/**
+ * Staged reindex: block-file readers, parallel deserializers, batched
+ * HashLatticePOW verifiers and parallel transaction merkle root
+ * workers, connected by bounded lock-free queues so disk, parsing and hashing
+ * overlap. A full queue stalls its producer, which bounds memory. Headers
+ * pPoWCache already verified skip the lattice rounds.
+ *
+ * Blocks reach the handler in completion order, not file order; reindex
+ * already copes with that through its unknown-parent map.
+ */
+class CReindexPipeline
+{
+public:
+    typedef std::unique_ptr<ReindexBlock> Item;
+    typedef std::function<void(const ReindexBlock& block)> BlockHandler;
+
+    CReindexPipeline(const ReindexPipelineOptions& optionsIn, const unsigned char pchMessageStartIn[4]);
+
+    /** Process vFiles; handler runs serially on the calling thread */
+    void Run(const std::vector<std::string>& vFiles, const BlockHandler& handler);
+    void Interrupt() { fInterrupt = true; }
+
+    const ReindexStageStats& GetStats(ReindexStage stage) const { return stats[stage]; }
+    std::string FormatStats() const;
+
+private:
+    const ReindexPipelineOptions options;
+    unsigned char pchMessageStart[4];
+
+    std::unique_ptr<CLockFreeQueue<Item>> queues[NUM_REINDEX_STAGES];   // Output queue of each stage
+    std::atomic<int> nActive[NUM_REINDEX_STAGES];
+    ReindexStageStats stats[NUM_REINDEX_STAGES];
+    CMetricHistogram* stageTimings[NUM_REINDEX_STAGES];
+    std::atomic<bool> fInterrupt;
+    std::atomic<size_t> nNextFile;
+    std::vector<std::string> vFiles;
+    double nElapsed;
+
+    bool Pop(ReindexStage upstream, Item& item);
+    void Push(ReindexStage stage, Item&& item);
+
+    void ThreadRead();
+    void ThreadParse();
+    void ThreadPoW();
+    void ThreadMerkle();
+    void ReadFile(int nFile);
+};
+
+#endif // LATTICE_REINDEX_H
@@ -0,0 +1,178 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sharevalidator.h"
+
+#include "crypto/sha3.h"
+
+#include <algorithm>
+#include <cstring>
+
+CShareSet::CShareSet(size_t nMaxEntriesIn) : nMaxEntries(nMaxEntriesIn), nEntries(0)
+{
+    // At most half full, so probe sequences stay short
+    size_t nSlots = 16;
+    while (nSlots < 2 * nMaxEntries)
+        nSlots <<= 1;
+    slots.reset(new std::atomic<uint64_t>[nSlots]);
+    for (size_t i = 0; i < nSlots; i++) {
+        slots[i].store(0, std::memory_order_relaxed);
+    }
+    mask = nSlots - 1;
+}
+
+bool CShareSet::Contains(uint64_t nFingerprint) const
+{
+    nFingerprint = nFingerprint ? nFingerprint : 1;
+    for (size_t i = nFingerprint & mask;; i = (i + 1) & mask) {
+        uint64_t nSlot = slots[i].load(std::memory_order_acquire);
+        if (nSlot == nFingerprint)
+            return true;
+        if (nSlot == 0)
+            return false;
+    }
+}
+
+CShareSet::InsertResult CShareSet::Insert(uint64_t nFingerprint)
+{
+    nFingerprint = nFingerprint ? nFingerprint : 1;
+    bool fReserved = false;
+    for (size_t i = nFingerprint & mask;; i = (i + 1) & mask) {
+        uint64_t nSlot = slots[i].load(std::memory_order_acquire);
+        if (nSlot == nFingerprint) {
+            if (fReserved)
+                nEntries.fetch_sub(1, std::memory_order_relaxed);
+            return SHARE_SET_DUPLICATE;
+        }
+        if (nSlot != 0)
+            continue;
+        // Only a probe that reaches an empty slot adds an entry, so capacity is checked here
+        if (!fReserved) {
+            if (nEntries.fetch_add(1, std::memory_order_relaxed) >= nMaxEntries) {
+                nEntries.fetch_sub(1, std::memory_order_relaxed);
+                return SHARE_SET_FULL;
+            }
+            fReserved = true;
+        }
+        if (slots[i].compare_exchange_strong(nSlot, nFingerprint, std::memory_order_acq_rel))
+            return SHARE_SET_ADDED;
+        // Lost the slot; the winner may have inserted the same fingerprint
+        if (nSlot == nFingerprint) {
+            nEntries.fetch_sub(1, std::memory_order_relaxed);
+            return SHARE_SET_DUPLICATE;
+        }
+    }
+}
+
+/** Keccak-512 state after a header's first 72 bytes */
+struct PrefixState {
+    uint64_t st[25];
+};
+
+CShareValidator::CShareValidator(const arith_uint256& shareTargetIn, size_t nQueueSize) :
+    shareTarget(shareTargetIn), queue(nQueueSize), nBatches(0), nHashed(0), nLanes(0), nPrefixReuse(0)
+{
+}
+
+bool CShareValidator::Submit(ShareSubmission&& share)
+{
+    return queue.TryPush(std::move(share));
+}
+
+void CShareValidator::Finish(const ShareSubmission& share, CShareSet& setShares, uint64_t nFingerprint, const uint256& powHash)
+{
+    arith_uint256 bnHash = UintToArith256(powHash);
+    ShareResult result;
+    if (bnHash > shareTarget) {
+        result = SHARE_LOW_DIFFICULTY;
+    } else {
+        CShareSet::InsertResult insert = setShares.Insert(nFingerprint);
+        if (insert == CShareSet::SHARE_SET_DUPLICATE) {
+            result = SHARE_DUPLICATE;
+        } else if (insert == CShareSet::SHARE_SET_FULL) {
+            result = SHARE_JOB_FULL;
+        } else {
+            arith_uint256 bnTarget;
+            bnTarget.SetCompact(share.job->nBits);
+            result = bnHash <= bnTarget ? SHARE_BLOCK : SHARE_ACCEPTED;
+        }
+    }
+    if (share.callback)
+        share.callback(share, result, powHash);
+}
+
+size_t CShareValidator::Process()
+{
+    std::vector<ShareSubmission> vShares;
+    vShares.reserve(SHARE_BATCH_SIZE);
+    ShareSubmission share;
+    while (vShares.size() < SHARE_BATCH_SIZE && queue.TryPop(share)) {
+        vShares.push_back(std::move(share));
+    }
+    if (vShares.empty())
+        return 0;
+    nBatches++;
+
+    // Group by job, then by header prefix
+    std::vector<size_t> vOrder(vShares.size());
+    for (size_t i = 0; i < vOrder.size(); i++)
+        vOrder[i] = i;
+    std::sort(vOrder.begin(), vOrder.end(), [&vShares](size_t a, size_t b) {
+        const ShareSubmission& x = vShares[a];
+        const ShareSubmission& y = vShares[b];
+        if (x.job != y.job)
+            return x.job < y.job;
+        return memcmp(x.header, y.header, 72) < 0;
+    });
+
+    std::vector<uint64_t> vFingerprint(vShares.size());
+    std::vector<size_t> vPending;
+    std::vector<PrefixState> vPrefix;
+    for (size_t nBegin = 0; nBegin < vOrder.size();) {
+        CStratumJob& job = *vShares[vOrder[nBegin]].job;
+        CShareSet& setShares = job.GetShareSet();
+        size_t nEnd = nBegin;
+        vPending.clear();
+        vPrefix.clear();
+        for (; nEnd < vOrder.size() && vShares[vOrder[nEnd]].job.get() == &job; nEnd++) {
+            size_t i = vOrder[nEnd];
+            vFingerprint[i] = job.GetShareFingerprint(vShares[i].header);
+            if (setShares.Contains(vFingerprint[i])) {
+                if (vShares[i].callback)
+                    vShares[i].callback(vShares[i], SHARE_DUPLICATE, uint256());
+                continue;
+            }
+            // Sorted, so equal prefixes are adjacent
+            if (!vPending.empty() && memcmp(vShares[vPending.back()].header, vShares[i].header, 72) == 0) {
+                vPrefix.push_back(vPrefix.back());
+                nPrefixReuse++;
+            } else {
+                vPrefix.emplace_back();
+                Keccak512_80Prefix(vShares[i].header, vPrefix.back().st);
+            }
+            vPending.push_back(i);
+        }
+
+        for (size_t p = 0; p < vPending.size(); p += 4) {
+            const unsigned char* header[4];
+            const uint64_t* prefix[4];
+            for (int k = 0; k < 4; k++) {
+                // Pad a short last group with its final share
+                size_t n = std::min(p + k, vPending.size() - 1);
+                header[k] = vShares[vPending[n]].header;
+                prefix[k] = vPrefix[n].st;
+            }
+            uint256 powHash[4];
+            HashLatticePOW4(header, prefix, job.roundTable, powHash);
+            nLanes += 4;
+            for (size_t k = 0; k < 4 && p + k < vPending.size(); k++) {
+                size_t i = vPending[p + k];
+                nHashed++;
+                Finish(vShares[i], setShares, vFingerprint[i], powHash[k]);
+            }
+        }
+        nBegin = nEnd;
+    }
+    return vShares.size();
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_SHAREVALIDATOR_H
+#define LATTICE_SHAREVALIDATOR_H
+
+#include "arith_uint256.h"
+#include "lockfreequeue.h"
+#include "stratum.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+static const size_t DEFAULT_SHARE_QUEUE_SIZE = 1 << 16;
+/** Shares one Process() call takes off the queue and verifies together */
+static const size_t SHARE_BATCH_SIZE = 64;
+
+/**
+ * Fixed-capacity lock-free set of 64-bit fingerprints (open addressing,
+ * linear probing, compare-and-swap into empty slots). Entries are never
+ * removed; the set lives as long as the job it deduplicates, and refuses
+ * new entries past nMaxEntries so memory per job stays bounded.
+ */
+class CShareSet
+{
+public:
+    enum InsertResult {
+        SHARE_SET_ADDED,
+        SHARE_SET_DUPLICATE,
+        SHARE_SET_FULL,
+    };
+
+    explicit CShareSet(size_t nMaxEntriesIn);
+
+    bool Contains(uint64_t nFingerprint) const;
+    InsertResult Insert(uint64_t nFingerprint);
+    size_t Size() const { return std::min(nEntries.load(std::memory_order_relaxed), nMaxEntries); }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;     // 0 marks an empty slot
+    size_t mask;
+    const size_t nMaxEntries;
+    std::atomic<size_t> nEntries;
+};
+
+enum ShareResult {
+    SHARE_ACCEPTED,
+    SHARE_BLOCK,                    // Accepted and also meets the job's block target
+    SHARE_LOW_DIFFICULTY,
+    SHARE_DUPLICATE,
+    SHARE_JOB_FULL,                 // The job's duplicate set is at capacity
+};
+
+struct ShareSubmission {
+    std::shared_ptr<CStratumJob> job;
+    unsigned char header[STRATUM_HEADER_SIZE];
+    /** Runs on the validating thread; powHash is null for duplicates caught before hashing */
+    std::function<void(const ShareSubmission& share, ShareResult result, const uint256& powHash)> callback;
+};
+
+/**
+ * Pool-side share validation engine.
+ *
+ * Producers Submit() shares into a lock-free MPMC queue; any thread then
+ * calls Process() to take a batch. A batch is grouped by job, so all of a
+ * group hashes through the job's round table, and within a job by header
+ * prefix, so shares with the same first 72 bytes (same miner extranonce
+ * and ntime) share one Keccak prefix permutation. Groups are hashed four
+ * at a time with HashLatticePOW4, padding the last group of a job.
+ *
+ * Duplicates go through the job's CShareSet, keyed with
+ * SipHashUint256Extra over the merkle root and nonce: a lookup before
+ * hashing skips known duplicates, and the insert after the target check
+ * decides races between identical submissions. Shares that fail the
+ * target are never inserted, so junk cannot fill a job's set.
+ *
+ * Nothing is shared between Process() calls except the queue and the
+ * per-job sets, so throughput scales with the threads calling it.
+ */
+class CShareValidator
+{
+public:
+    CShareValidator(const arith_uint256& shareTargetIn, size_t nQueueSize = DEFAULT_SHARE_QUEUE_SIZE);
+
+    /** Queue a share; false if the queue is full */
+    bool Submit(ShareSubmission&& share);
+
+    /** Validate up to SHARE_BATCH_SIZE queued shares on the calling thread; returns how many */
+    size_t Process();
+
+    size_t GetQueueDepth() const { return queue.SizeApprox(); }
+    uint64_t GetBatches() const { return nBatches; }
+    uint64_t GetSharesHashed() const { return nHashed; }
+    /** HashLatticePOW4 lanes used, including padding; GetSharesHashed() / GetLanes() is the fill rate */
+    uint64_t GetLanes() const { return nLanes; }
+    uint64_t GetPrefixReuse() const { return nPrefixReuse; }
+
+private:
+    const arith_uint256 shareTarget;
+    CLockFreeQueue<ShareSubmission> queue;
+
+    std::atomic<uint64_t> nBatches;
+    std::atomic<uint64_t> nHashed;
+    std::atomic<uint64_t> nLanes;
+    std::atomic<uint64_t> nPrefixReuse;
+
+    void Finish(const ShareSubmission& share, CShareSet& setShares, uint64_t nFingerprint, const uint256& powHash);
+};
+
+#endif // LATTICE_SHAREVALIDATOR_H
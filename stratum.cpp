@@ -0,0 +1,880 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "stratum.h"
+
+#include "crypto/common.h"
+#include "crypto/sha3.h"
+#include "latticemetrics.h"
+#include "latticeprecompute.h"
+#include "latticeplacement.h"
+#include "latticeprofile.h"
+#include "mergedmining.h"
+#include "minergovernor.h"
+#include "random.h"
+#include "sharevalidator.h"
+#include "univalue.h"
+#include "util.h"
+#include "utilstrencodings.h"
+
+#include <cstring>
+#include <limits>
+
+// Stratum error codes
+static const int STRATUM_ERROR_OTHER = 20;
+static const int STRATUM_ERROR_JOB_NOT_FOUND = 21;
+static const int STRATUM_ERROR_DUPLICATE = 22;
+static const int STRATUM_ERROR_LOW_DIFFICULTY = 23;
+static const int STRATUM_ERROR_UNAUTHORIZED = 24;
+static const int STRATUM_ERROR_NOT_SUBSCRIBED = 25;
+
+static std::string HexUint32(uint32_t n)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, n);
+    return HexStr(buf, buf + 4);
+}
+
+static bool ParseUint32Hex(const std::string& str, uint32_t& n)
+{
+    if (str.size() != 8 || !IsHex(str))
+        return false;
+    std::vector<unsigned char> vch = ParseHex(str);
+    n = ReadBE32(vch.data());
+    return true;
+}
+
+static bool ParseHashHex(const std::string& str, uint256& hash)
+{
+    if (str.size() != 64 || !IsHex(str))
+        return false;
+    std::vector<unsigned char> vch = ParseHex(str);
+    memcpy(hash.begin(), vch.data(), 32);
+    return true;
+}
+
+static UniValue StratumError(int code, const std::string& message)
+{
+    UniValue error(UniValue::VARR);
+    error.push_back(code);
+    error.push_back(message);
+    error.push_back(NullUniValue);
+    return error;
+}
+
+static std::string StratumReply(const UniValue& id, const UniValue& result, const UniValue& error)
+{
+    UniValue reply(UniValue::VOBJ);
+    reply.pushKV("id", id);
+    reply.pushKV("result", result);
+    reply.pushKV("error", error);
+    return reply.write() + "\n";
+}
+
+static std::string StratumNotification(const std::string& method, const UniValue& params)
+{
+    UniValue notification(UniValue::VOBJ);
+    notification.pushKV("id", NullUniValue);
+    notification.pushKV("method", method);
+    notification.pushKV("params", params);
+    return notification.write() + "\n";
+}
+
+static bool SendAll(SOCKET hSocket, const std::string& data)
+{
+    size_t nSent = 0;
+    while (nSent < data.size()) {
+        ssize_t n = send(hSocket, data.data() + nSent, data.size() - nSent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && (errno == EINTR || errno == EAGAIN))
+                continue;
+            return false;
+        }
+        nSent += n;
+    }
+    return true;
+}
+
+/** Pop one '\n'-terminated line from buffer */
+static bool PopLine(std::string& buffer, std::string& line)
+{
+    size_t pos = buffer.find('\n');
+    if (pos == std::string::npos)
+        return false;
+    line = buffer.substr(0, pos);
+    buffer.erase(0, pos + 1);
+    return true;
+}
+
+std::vector<uint256> ComputeStratumMerkleBranch(const std::vector<uint256>& vTxHashes)
+{
+    std::vector<uint256> vMerkleBranch;
+
+    // Slot 0 of every level is the (unknown) path from the coinbase
+    std::vector<uint256> level(1);
+    level.insert(level.end(), vTxHashes.begin(), vTxHashes.end());
+
+    while (level.size() > 1) {
+        vMerkleBranch.push_back(level[1]);
+        if (level.size() & 1)
+            level.push_back(level.back());
+
+        std::vector<uint256> next(1);
+        for (size_t i = 2; i < level.size(); i += 2) {
+            next.push_back(Hash(level[i].begin(), level[i].end(), level[i + 1].begin(), level[i + 1].end()));
+        }
+        level.swap(next);
+    }
+
+    return vMerkleBranch;
+}
+
+uint256 ComputeStratumMerkleRoot(const uint256& leaf, const std::vector<uint256>& vMerkleBranch)
+{
+    uint256 root = leaf;
+    for (const uint256& hash : vMerkleBranch) {
+        root = Hash(root.begin(), root.end(), hash.begin(), hash.end());
+    }
+    return root;
+}
+
+CStratumJob::CStratumJob(const std::string& idIn, const StratumTemplate& tmpl, const LatticeRoundTable& roundTableIn) :
+    id(idIn), nVersion(tmpl.nVersion), hashPrevBlock(tmpl.hashPrevBlock), nTime(tmpl.nTime), nBits(tmpl.nBits),
+    coinb1(tmpl.coinbasePrefix), coinb2(tmpl.coinbaseSuffix), vMerkleBranch(ComputeStratumMerkleBranch(tmpl.vTxHashes)),
+    roundTable(roundTableIn), mergedWork(tmpl.mergedWork),
+    nShareKey0(GetRand(std::numeric_limits<uint64_t>::max())), nShareKey1(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+}
+
+CStratumJob::CStratumJob(const std::string& idIn, int32_t nVersionIn, const uint256& hashPrevBlockIn, uint32_t nTimeIn, uint32_t nBitsIn,
+                         const std::vector<unsigned char>& coinb1In, const std::vector<unsigned char>& coinb2In,
+                         const std::vector<uint256>& vMerkleBranchIn, const LatticeRoundTable& roundTableIn) :
+    id(idIn), nVersion(nVersionIn), hashPrevBlock(hashPrevBlockIn), nTime(nTimeIn), nBits(nBitsIn),
+    coinb1(coinb1In), coinb2(coinb2In), vMerkleBranch(vMerkleBranchIn), roundTable(roundTableIn),
+    nShareKey0(GetRand(std::numeric_limits<uint64_t>::max())), nShareKey1(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+}
+
+std::vector<unsigned char> CStratumJob::GetCoinbase(const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2) const
+{
+    std::vector<unsigned char> vCoinbase(coinb1);
+    vCoinbase.insert(vCoinbase.end(), extranonce1.begin(), extranonce1.end());
+    vCoinbase.insert(vCoinbase.end(), extranonce2.begin(), extranonce2.end());
+    vCoinbase.insert(vCoinbase.end(), coinb2.begin(), coinb2.end());
+    return vCoinbase;
+}
+
+uint256 CStratumJob::GetMerkleRoot(const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2) const
+{
+    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+    ss.write((const char*)coinb1.data(), coinb1.size());
+    ss.write((const char*)extranonce1.data(), extranonce1.size());
+    ss.write((const char*)extranonce2.data(), extranonce2.size());
+    ss.write((const char*)coinb2.data(), coinb2.size());
+    return ComputeStratumMerkleRoot(ss.GetHash(), vMerkleBranch);
+}
+
+void CStratumJob::BuildHeader(const uint256& merkleRoot, uint32_t nTimeIn, uint32_t nNonce, unsigned char header[STRATUM_HEADER_SIZE]) const
+{
+    WriteLE32(header, nVersion);
+    memcpy(header + 4, hashPrevBlock.begin(), 32);
+    memcpy(header + 36, merkleRoot.begin(), 32);
+    WriteLE32(header + 68, nTimeIn);
+    WriteLE32(header + 72, nBits);
+    WriteLE32(header + 76, nNonce);
+}
+
+uint256 CStratumJob::GetPoWHash(const unsigned char header[STRATUM_HEADER_SIZE]) const
+{
+    return HashLatticePOW(header, header + STRATUM_HEADER_SIZE, roundTable);
+}
+
+uint64_t CStratumJob::GetShareFingerprint(const unsigned char header[STRATUM_HEADER_SIZE]) const
+{
+    uint256 merkleRoot;
+    memcpy(merkleRoot.begin(), header + 36, 32);
+    return SipHashUint256Extra(nShareKey0 ^ ReadLE32(header + 68), nShareKey1, merkleRoot, ReadLE32(header + 76));
+}
+
+CShareSet& CStratumJob::GetShareSet()
+{
+    std::lock_guard<std::mutex> lock(cs_submitted);
+    if (!setSubmitted)
+        setSubmitted.reset(new CShareSet(STRATUM_MAX_JOB_SHARES));
+    return *setSubmitted;
+}
+
+CStratumWorkQueue::CStratumWorkQueue(int nThreads) : fInterrupt(false)
+{
+    for (int i = 0; i < std::max(nThreads, 1); i++) {
+        threads.emplace_back(&CStratumWorkQueue::ThreadWorker, this);
+    }
+}
+
+CStratumWorkQueue::~CStratumWorkQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        fInterrupt = true;
+    }
+    cond.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void CStratumWorkQueue::Enqueue(std::function<void()> func)
+{
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        queue.push_back(std::move(func));
+    }
+    cond.notify_one();
+}
+
+size_t CStratumWorkQueue::Depth()
+{
+    std::lock_guard<std::mutex> lock(cs);
+    return queue.size();
+}
+
+void CStratumWorkQueue::ThreadWorker()
+{
+    RenameThread("lattice-stratum-val");
+    CWorkerPlacement placement;
+    while (true) {
+        std::function<void()> func;
+        {
+            std::unique_lock<std::mutex> lock(cs);
+            cond.wait(lock, [this] { return fInterrupt || !queue.empty(); });
+            if (fInterrupt && queue.empty())
+                return;
+            func = std::move(queue.front());
+            queue.pop_front();
+        }
+        func();
+    }
+}
+
+struct StratumClient {
+    SOCKET hSocket;
+    std::vector<unsigned char> extranonce1;
+    std::string recvBuffer;
+    std::atomic<bool> fSubscribed;
+    std::atomic<bool> fAuthorized;
+    std::atomic<bool> fDisconnect;
+    std::mutex cs_send;
+
+    StratumClient(SOCKET hSocketIn, uint32_t nExtraNonce1) :
+        hSocket(hSocketIn), extranonce1(STRATUM_EXTRANONCE1_SIZE), fSubscribed(false), fAuthorized(false), fDisconnect(false)
+    {
+        WriteBE32(extranonce1.data(), nExtraNonce1);
+    }
+
+    // Validation threads may still hold a reference after the network
+    // thread drops the client, so the socket is only closed here.
+    ~StratumClient()
+    {
+        CloseSocket(hSocket);
+    }
+
+    void Send(const std::string& data)
+    {
+        std::lock_guard<std::mutex> lock(cs_send);
+        if (fDisconnect)
+            return;
+        if (!SendAll(hSocket, data)) {
+            fDisconnect = true;
+        }
+    }
+};
+
+CStratumServer::CStratumServer(const arith_uint256& shareTargetIn, int nThreads, int nPoWVersionIn) :
+    shareTarget(shareTargetIn), nPoWVersion(nPoWVersionIn),
+    hListenSocket(INVALID_SOCKET), nListenPort(0), fInterrupt(false), nNextExtraNonce1(1), nJobSequence(0), precomputer(nullptr),
+    nSharesAccepted(0), nSharesRejected(0), nBlocksFound(0), shareValidator(new CShareValidator(shareTargetIn)),
+    validationQueue(nThreads)
+{
+    wakeupPipe[0] = wakeupPipe[1] = -1;
+    // Before the net and validation threads build tables, so a template's hashPrevBlock cannot seed it
+    InitializeLatticeMatrix(uint256S(LATTICE_MATRIX_DEFAULT_SEED));
+}
+
+CStratumServer::~CStratumServer()
+{
+    Stop();
+}
+
+size_t CStratumServer::GetValidationQueueDepth()
+{
+    return validationQueue.Depth() + shareValidator->GetQueueDepth();
+}
+
+bool CStratumServer::Start(uint16_t nPort)
+{
+    hListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (hListenSocket == INVALID_SOCKET) {
+        LogPrintf("Stratum: socket() failed: %d\n", WSAGetLastError());
+        return false;
+    }
+
+    int nOne = 1;
+    setsockopt(hListenSocket, SOL_SOCKET, SO_REUSEADDR, (void*)&nOne, sizeof(int));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(nPort);
+    if (bind(hListenSocket, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(hListenSocket, SOMAXCONN) == SOCKET_ERROR) {
+        LogPrintf("Stratum: unable to listen on port %u: %d\n", nPort, WSAGetLastError());
+        CloseSocket(hListenSocket);
+        return false;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(hListenSocket, (struct sockaddr*)&addr, &len);
+    nListenPort = ntohs(addr.sin_port);
+
+    if (pipe(wakeupPipe) != 0) {
+        CloseSocket(hListenSocket);
+        return false;
+    }
+
+    fInterrupt = false;
+    threadNet = std::thread(&CStratumServer::ThreadNet, this);
+    RegisterMetricGauge("lattice_stratum_validation_queue_depth", "Shares waiting for PoW verification",
+                        [this] { return (double)validationQueue.Depth(); });
+    LogPrintf("Stratum: listening on 127.0.0.1:%u\n", nListenPort);
+    return true;
+}
+
+void CStratumServer::Stop()
+{
+    if (!threadNet.joinable())
+        return;
+
+    UnregisterMetricGauge("lattice_stratum_validation_queue_depth");
+    fInterrupt = true;
+    char c = 0;
+    if (write(wakeupPipe[1], &c, 1) != 1) {
+        LogPrintf("Stratum: failed to wake network thread\n");
+    }
+    threadNet.join();
+
+    close(wakeupPipe[0]);
+    close(wakeupPipe[1]);
+    wakeupPipe[0] = wakeupPipe[1] = -1;
+    CloseSocket(hListenSocket);
+
+    std::lock_guard<std::mutex> lock(cs_clients);
+    for (auto& entry : mapClients) {
+        entry.second->fDisconnect = true;
+        shutdown(entry.first, SHUT_RDWR);
+    }
+    mapClients.clear();
+}
+
+size_t CStratumServer::GetClientCount()
+{
+    std::lock_guard<std::mutex> lock(cs_clients);
+    return mapClients.size();
+}
+
+void CStratumServer::ThreadNet()
+{
+    RenameThread("lattice-stratum-net");
+
+    while (!fInterrupt) {
+        std::vector<struct pollfd> vPollFds;
+        std::vector<std::shared_ptr<StratumClient>> vClients;
+
+        struct pollfd pfd;
+        pfd.events = POLLIN;
+        pfd.fd = wakeupPipe[0];
+        vPollFds.push_back(pfd);
+        pfd.fd = hListenSocket;
+        vPollFds.push_back(pfd);
+        {
+            std::lock_guard<std::mutex> lock(cs_clients);
+            for (auto& entry : mapClients) {
+                pfd.fd = entry.first;
+                vPollFds.push_back(pfd);
+                vClients.push_back(entry.second);
+            }
+        }
+
+        if (poll(vPollFds.data(), vPollFds.size(), 100) < 0) {
+            if (errno == EINTR)
+                continue;
+            LogPrintf("Stratum: poll() failed: %d\n", WSAGetLastError());
+            break;
+        }
+        if (fInterrupt)
+            break;
+
+        if (vPollFds[1].revents & POLLIN) {
+            AcceptConnection();
+        }
+
+        for (size_t i = 0; i < vClients.size(); i++) {
+            const std::shared_ptr<StratumClient>& client = vClients[i];
+            bool fReadable = vPollFds[i + 2].revents & (POLLIN | POLLHUP | POLLERR);
+            if (client->fDisconnect || (fReadable && !ReceiveFrom(client))) {
+                client->fDisconnect = true;
+                std::lock_guard<std::mutex> lock(cs_clients);
+                mapClients.erase(client->hSocket);
+            }
+        }
+    }
+}
+
+void CStratumServer::AcceptConnection()
+{
+    SOCKET hSocket = accept(hListenSocket, nullptr, nullptr);
+    if (hSocket == INVALID_SOCKET)
+        return;
+
+    int nOne = 1;
+    setsockopt(hSocket, IPPROTO_TCP, TCP_NODELAY, (void*)&nOne, sizeof(int));
+
+    std::lock_guard<std::mutex> lock(cs_clients);
+    mapClients[hSocket] = std::make_shared<StratumClient>(hSocket, nNextExtraNonce1++);
+}
+
+bool CStratumServer::ReceiveFrom(const std::shared_ptr<StratumClient>& client)
+{
+    char buf[0x4000];
+    ssize_t n = recv(client->hSocket, buf, sizeof(buf), MSG_DONTWAIT);
+    if (n < 0)
+        return errno == EAGAIN || errno == EINTR;
+    if (n == 0)
+        return false;
+
+    client->recvBuffer.append(buf, n);
+    std::string line;
+    while (PopLine(client->recvBuffer, line)) {
+        ProcessLine(client, line);
+    }
+    return client->recvBuffer.size() <= STRATUM_MAX_LINE;
+}
+
+void CStratumServer::ProcessLine(const std::shared_ptr<StratumClient>& client, const std::string& line)
+{
+    UniValue request;
+    if (!request.read(line) || !request.isObject()) {
+        client->fDisconnect = true;
+        return;
+    }
+
+    const UniValue& id = find_value(request, "id");
+    const UniValue& method = find_value(request, "method");
+    const UniValue& params = find_value(request, "params");
+    if (!method.isStr()) {
+        client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_OTHER, "Missing method")));
+        return;
+    }
+
+    if (method.get_str() == "mining.subscribe") {
+        std::string strExtraNonce1 = HexStr(client->extranonce1);
+        UniValue subscription(UniValue::VARR);
+        subscription.push_back("mining.notify");
+        subscription.push_back(strExtraNonce1);
+        UniValue subscriptions(UniValue::VARR);
+        subscriptions.push_back(subscription);
+        UniValue result(UniValue::VARR);
+        result.push_back(subscriptions);
+        result.push_back(strExtraNonce1);
+        result.push_back((int)STRATUM_EXTRANONCE2_SIZE);
+        client->Send(StratumReply(id, result, NullUniValue));
+
+        client->fSubscribed = true;
+        UniValue targetParams(UniValue::VARR);
+        targetParams.push_back(ArithToUint256(shareTarget).GetHex());
+        client->Send(StratumNotification("mining.set_target", targetParams));
+
+        std::shared_ptr<CStratumJob> job;
+        {
+            std::lock_guard<std::mutex> lock(cs_jobs);
+            if (!vJobs.empty())
+                job = vJobs.back();
+        }
+        if (job)
+            SendJob(client, *job, true);
+    } else if (method.get_str() == "mining.authorize") {
+        // Local miners only, so every worker name is accepted
+        client->fAuthorized = true;
+        client->Send(StratumReply(id, true, NullUniValue));
+    } else if (method.get_str() == "mining.submit") {
+        if (!client->fSubscribed) {
+            client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_NOT_SUBSCRIBED, "Not subscribed")));
+        } else if (!client->fAuthorized) {
+            client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_UNAUTHORIZED, "Unauthorized worker")));
+        } else {
+            validationQueue.Enqueue([this, client, id, params] { ProcessSubmit(client, id, params); });
+        }
+    } else {
+        client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_OTHER, "Method not found")));
+    }
+}
+
+void CStratumServer::ProcessSubmit(const std::shared_ptr<StratumClient>& client, const UniValue& id, const UniValue& params)
+{
+    // params: [worker, job_id, extranonce2, ntime, nonce]
+    CMetricTimer timer(g_lattice_metrics.verifyLatency);
+    uint32_t nTime, nNonce;
+    if (!params.isArray() || params.size() < 5 || !params[1].isStr() || !params[2].isStr() ||
+        !params[3].isStr() || !params[4].isStr() || !ParseUint32Hex(params[3].get_str(), nTime) ||
+        !ParseUint32Hex(params[4].get_str(), nNonce) || params[2].get_str().size() != 2 * STRATUM_EXTRANONCE2_SIZE ||
+        !IsHex(params[2].get_str())) {
+        nSharesRejected++;
+        g_lattice_metrics.sharesRejected.Add();
+        client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_OTHER, "Malformed share")));
+        return;
+    }
+
+    std::shared_ptr<CStratumJob> job = FindJob(params[1].get_str());
+    if (!job) {
+        nSharesRejected++;
+        g_lattice_metrics.sharesRejected.Add();
+        g_lattice_metrics.staleWork.Add();
+        client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_JOB_NOT_FOUND, "Job not found")));
+        return;
+    }
+    if (nTime < job->nTime || nTime > job->nTime + 7200) {
+        nSharesRejected++;
+        g_lattice_metrics.sharesRejected.Add();
+        client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_OTHER, "ntime out of range")));
+        return;
+    }
+
+    ShareSubmission share;
+    share.job = job;
+    std::vector<unsigned char> extranonce2 = ParseHex(params[2].get_str());
+    job->BuildHeader(job->GetMerkleRoot(client->extranonce1, extranonce2), nTime, nNonce, share.header);
+    share.callback = [this, client, id, extranonce2](const ShareSubmission& share, ShareResult result, const uint256& powHash) {
+        if (result != SHARE_ACCEPTED && result != SHARE_BLOCK) {
+            nSharesRejected++;
+            g_lattice_metrics.sharesRejected.Add();
+            if (result == SHARE_LOW_DIFFICULTY) {
+                client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_LOW_DIFFICULTY, "Low difficulty share")));
+            } else if (result == SHARE_DUPLICATE) {
+                client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_DUPLICATE, "Duplicate share")));
+            } else {
+                client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_OTHER, "Too many shares for job")));
+            }
+            return;
+        }
+
+        nSharesAccepted++;
+        g_lattice_metrics.sharesAccepted.Add();
+        client->Send(StratumReply(id, true, NullUniValue));
+
+        if (result == SHARE_BLOCK) {
+            nBlocksFound++;
+            LogPrintf("Stratum: block found on job %s: %s\n", share.job->id, powHash.GetHex());
+            if (BlockFound)
+                BlockFound(*share.job, share.header);
+        }
+        // Only accepted shares get here, so aux targets easier than the share target are never met
+        const CMergedMiningWork* mergedWork = share.job->mergedWork.get();
+        if (mergedWork && mergedWork->CheckHash(powHash) > 0) {
+            size_t nSolved = mergedWork->Route(share.header, share.job->GetCoinbase(client->extranonce1, extranonce2),
+                                               share.job->vMerkleBranch, powHash);
+            LogPrintf("Stratum: share on job %s solves %u aux chains\n", share.job->id, nSolved);
+        }
+    };
+    if (!shareValidator->Submit(std::move(share))) {
+        nSharesRejected++;
+        g_lattice_metrics.sharesRejected.Add();
+        client->Send(StratumReply(id, NullUniValue, StratumError(STRATUM_ERROR_OTHER, "Server busy")));
+        return;
+    }
+    // Whichever validation thread gets here first hashes everything queued so far in one batch
+    shareValidator->Process();
+}
+
+void CStratumServer::SendJob(const std::shared_ptr<StratumClient>& client, const CStratumJob& job, bool fCleanJobs)
+{
+    UniValue branch(UniValue::VARR);
+    for (const uint256& hash : job.vMerkleBranch) {
+        branch.push_back(HexStr(hash.begin(), hash.end()));
+    }
+
+    UniValue params(UniValue::VARR);
+    params.push_back(job.id);
+    params.push_back(HexStr(job.hashPrevBlock.begin(), job.hashPrevBlock.end()));
+    params.push_back(HexStr(job.coinb1));
+    params.push_back(HexStr(job.coinb2));
+    params.push_back(branch);
+    params.push_back(HexUint32(job.nVersion));
+    params.push_back(HexUint32(job.nBits));
+    params.push_back(HexUint32(job.nTime));
+    params.push_back(fCleanJobs);
+    client->Send(StratumNotification("mining.notify", params));
+}
+
+void CStratumServer::NotifyTemplate(const StratumTemplate& tmpl, bool fCleanJobs)
+{
+    // Outside cs_jobs: on a tip switch without a precomputed table this expands the tip's matrix
+    LatticeTipState tip;
+    if (precomputer) {
+        precomputer->GetTip(tmpl.hashPrevBlock, nPoWVersion, tip);
+    } else {
+        BuildLatticeRoundTable(tmpl.hashPrevBlock, nPoWVersion, tip.table);
+    }
+
+    std::shared_ptr<CStratumJob> job;
+    {
+        std::lock_guard<std::mutex> lock(cs_jobs);
+        job = std::make_shared<CStratumJob>(HexUint32(++nJobSequence), tmpl, tip.table);
+        if (fCleanJobs)
+            vJobs.clear();
+        vJobs.push_back(job);
+        while (vJobs.size() > STRATUM_MAX_STALE_JOBS + 1)
+            vJobs.pop_front();
+    }
+
+    std::vector<std::shared_ptr<StratumClient>> vClients;
+    {
+        std::lock_guard<std::mutex> lock(cs_clients);
+        for (auto& entry : mapClients) {
+            if (entry.second->fSubscribed)
+                vClients.push_back(entry.second);
+        }
+    }
+    for (const std::shared_ptr<StratumClient>& client : vClients) {
+        SendJob(client, *job, fCleanJobs);
+    }
+}
+
+std::shared_ptr<CStratumJob> CStratumServer::FindJob(const std::string& jobId)
+{
+    std::lock_guard<std::mutex> lock(cs_jobs);
+    for (const std::shared_ptr<CStratumJob>& job : vJobs) {
+        if (job->id == jobId)
+            return job;
+    }
+    return nullptr;
+}
+
+CStratumLoopbackMiner::CStratumLoopbackMiner(int nPoWVersionIn) :
+    governor(nullptr), nGovernorWorker(0), precomputer(nullptr), nHashes(0), nSharesSubmitted(0), nSharesAccepted(0), nSharesRejected(0),
+    nPoWVersion(nPoWVersionIn), hSocket(INVALID_SOCKET), nExtraNonce2(0), nNonce(0), nNextRequestId(1)
+{
+    InitializeLatticeMatrix(uint256S(LATTICE_MATRIX_DEFAULT_SEED));
+}
+
+CStratumLoopbackMiner::~CStratumLoopbackMiner()
+{
+    CloseSocket(hSocket);
+}
+
+bool CStratumLoopbackMiner::Connect(uint16_t nPort)
+{
+    hSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (hSocket == INVALID_SOCKET)
+        return false;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(nPort);
+    if (connect(hSocket, (struct sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) {
+        CloseSocket(hSocket);
+        return false;
+    }
+
+    int nOne = 1;
+    setsockopt(hSocket, IPPROTO_TCP, TCP_NODELAY, (void*)&nOne, sizeof(int));
+
+    UniValue authorize(UniValue::VARR);
+    authorize.push_back("loopback");
+    authorize.push_back("x");
+    return SendRequest("mining.subscribe", UniValue(UniValue::VARR)) && SendRequest("mining.authorize", authorize);
+}
+
+bool CStratumLoopbackMiner::SendRequest(const std::string& method, const UniValue& params)
+{
+    UniValue request(UniValue::VOBJ);
+    request.pushKV("id", nNextRequestId++);
+    request.pushKV("method", method);
+    request.pushKV("params", params);
+    return SendAll(hSocket, request.write() + "\n");
+}
+
+bool CStratumLoopbackMiner::PollMessages(bool fBlock)
+{
+    struct pollfd pfd;
+    pfd.fd = hSocket;
+    pfd.events = POLLIN;
+    while (poll(&pfd, 1, fBlock ? 100 : 0) > 0) {
+        char buf[0x4000];
+        ssize_t n = recv(hSocket, buf, sizeof(buf), 0);
+        if (n <= 0)
+            return false;
+        recvBuffer.append(buf, n);
+
+        std::string line;
+        while (PopLine(recvBuffer, line)) {
+            if (!ProcessLine(line))
+                return false;
+        }
+        fBlock = false;
+    }
+    return true;
+}
+
+bool CStratumLoopbackMiner::ProcessLine(const std::string& line)
+{
+    UniValue message;
+    if (!message.read(line) || !message.isObject())
+        return false;
+
+    const UniValue& method = find_value(message, "method");
+    const UniValue& params = find_value(message, "params");
+    if (!method.isStr()) {
+        // Reply: 1 is mining.subscribe, 2 is mining.authorize, the rest are shares
+        const UniValue& id = find_value(message, "id");
+        const UniValue& result = find_value(message, "result");
+        if (!id.isNum())
+            return false;
+        if (id.get_int() == 1) {
+            if (!result.isArray() || result.size() < 3 || !result[1].isStr())
+                return false;
+            extranonce1 = ParseHex(result[1].get_str());
+        } else if (id.get_int() > 2) {
+            if (result.isBool() && result.get_bool()) {
+                nSharesAccepted++;
+            } else {
+                nSharesRejected++;
+            }
+        }
+        return true;
+    }
+
+    if (method.get_str() == "mining.set_target") {
+        if (!params.isArray() || params.size() < 1 || !params[0].isStr())
+            return false;
+        shareTarget = UintToArith256(uint256S(params[0].get_str()));
+    } else if (method.get_str() == "mining.notify") {
+        // params: [job_id, prevhash, coinb1, coinb2, merkle_branch, version, nbits, ntime, clean_jobs]
+        if (!params.isArray() || params.size() < 9 || !params[4].isArray())
+            return false;
+        for (size_t i = 0; i < 8; i++) {
+            if (i != 4 && !params[i].isStr())
+                return false;
+        }
+        uint256 hashPrevBlock;
+        uint32_t nVersion, nBits, nTime;
+        std::vector<uint256> vMerkleBranch(params[4].size());
+        for (size_t i = 0; i < params[4].size(); i++) {
+            if (!params[4][i].isStr() || !ParseHashHex(params[4][i].get_str(), vMerkleBranch[i]))
+                return false;
+        }
+        if (!ParseHashHex(params[1].get_str(), hashPrevBlock) || !ParseUint32Hex(params[5].get_str(), nVersion) ||
+            !ParseUint32Hex(params[6].get_str(), nBits) || !ParseUint32Hex(params[7].get_str(), nTime))
+            return false;
+        // Same tip keeps its table and any speculative midstate
+        if (!job || job->hashPrevBlock != hashPrevBlock) {
+            if (precomputer) {
+                precomputer->GetTip(hashPrevBlock, nPoWVersion, tip);
+            } else {
+                tip.fPrefix = false;
+                BuildLatticeRoundTable(hashPrevBlock, nPoWVersion, tip.table);
+            }
+        }
+        job = std::make_shared<CStratumJob>(params[0].get_str(), nVersion, hashPrevBlock, nTime, nBits,
+                                            ParseHex(params[2].get_str()), ParseHex(params[3].get_str()),
+                                            vMerkleBranch, tip.table);
+        nExtraNonce2 = 0;
+        nNonce = 0;
+    }
+    return true;
+}
+
+bool CStratumLoopbackMiner::Run(const std::atomic<bool>& fStop)
+{
+    std::vector<unsigned char> extranonce2(STRATUM_EXTRANONCE2_SIZE);
+    std::shared_ptr<CStratumJob> currentJob;
+    unsigned char header[4][STRATUM_HEADER_SIZE];
+    const unsigned char* headers[4] = {header[0], header[1], header[2], header[3]};
+    uint64_t prefix[25];
+    const uint64_t* prefixes[4] = {prefix, prefix, prefix, prefix};
+    CWorkerPlacement placement;
+    LatticeRoundTable table;
+
+    while (!fStop) {
+        if (!PollMessages(!job || extranonce1.empty()))
+            return false;
+        if (!job || extranonce1.empty())
+            continue;
+
+        if (currentJob != job || nNonce == 0) {
+            if (currentJob != job) {
+                table = job->roundTable;
+                placement.LocalizeRoundTable(table);
+            }
+            currentJob = job;
+            WriteBE32(extranonce2.data(), nExtraNonce2);
+            currentJob->BuildHeader(currentJob->GetMerkleRoot(extranonce1, extranonce2), currentJob->nTime, 0, header[0]);
+            for (int k = 1; k < 4; k++) {
+                memcpy(header[k], header[0], STRATUM_HEADER_SIZE);
+            }
+            // A tip announced with this header's prefix skips the prefix permutation
+            const uint64_t* midstate = tip.GetMidstate(header[0]);
+            if (midstate) {
+                memcpy(prefix, midstate, sizeof(prefix));
+            } else {
+                Keccak512_80Prefix(header[0], prefix);
+            }
+        }
+
+        // Check for new work between batches of nonces
+        int64_t nBatchStart = MetricNanos();
+        {
+            CPerfScope scope("mine_batch", 256);
+            for (int i = 0; i < 256; i += 4) {
+                for (int k = 0; k < 4; k++) {
+                    WriteLE32(header[k] + 76, nNonce + k);
+                }
+                uint256 powHash[4];
+                int64_t nStart = MetricNanos();
+                HashLatticePOW4(headers, prefixes, table, powHash);
+                int64_t nElapsed = MetricNanos() - nStart;
+                for (int k = 0; k < 4; k++) {
+                    g_lattice_metrics.hashLatency.Observe(nElapsed / 4);
+                }
+                g_lattice_metrics.hashes.Add(4);
+                nHashes += 4;
+
+                for (int k = 0; k < 4; k++) {
+                    if (UintToArith256(powHash[k]) <= shareTarget) {
+                        UniValue params(UniValue::VARR);
+                        params.push_back("loopback");
+                        params.push_back(currentJob->id);
+                        params.push_back(HexStr(extranonce2));
+                        params.push_back(HexUint32(currentJob->nTime));
+                        params.push_back(HexUint32(nNonce + k));
+                        if (!SendRequest("mining.submit", params))
+                            return false;
+                        nSharesSubmitted++;
+                    }
+                }
+
+                // Nonces advance four at a time, so they wrap at a group boundary
+                nNonce += 4;
+                if (nNonce == 0) {
+                    nExtraNonce2++;
+                    scope.SetItems(i + 4);
+                    break;
+                }
+            }
+        }
+        if (governor)
+            governor->Pace(nGovernorWorker, MetricNanos() - nBatchStart, fStop);
+    }
+    return true;
+}
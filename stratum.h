@@ -0,0 +1,235 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef LATTICE_STRATUM_H
+#define LATTICE_STRATUM_H
+
+#include "arith_uint256.h"
+#include "compat.h"
+#include "hash.h"
+#include "latticeprecompute.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CMergedMiningWork;
+class CMinerGovernor;
+class CShareSet;
+class CShareValidator;
+class UniValue;
+
+static const uint16_t DEFAULT_STRATUM_PORT = 3333;
+static const int DEFAULT_STRATUM_THREADS = 4;
+static const unsigned int STRATUM_EXTRANONCE1_SIZE = 4;
+static const unsigned int STRATUM_EXTRANONCE2_SIZE = 4;
+static const unsigned int STRATUM_HEADER_SIZE = 80;
+/** Number of superseded jobs still accepting shares */
+static const unsigned int STRATUM_MAX_STALE_JOBS = 4;
+/** Longest line a client may send before it is disconnected */
+static const size_t STRATUM_MAX_LINE = 4096;
+/** Accepted shares a job remembers for duplicate detection; later shares are refused */
+static const size_t STRATUM_MAX_JOB_SHARES = 1 << 17;
+
+/** Block template fields a Stratum job is cut from. */
+struct StratumTemplate {
+    int32_t nVersion;
+    uint256 hashPrevBlock;
+    uint32_t nTime;
+    uint32_t nBits;
+    std::vector<unsigned char> coinbasePrefix;  // Serialized coinbase up to the extranonce
+    std::vector<unsigned char> coinbaseSuffix;  // Serialized coinbase after the extranonce
+    std::vector<uint256> vTxHashes;             // Non-coinbase transaction hashes, block order
+    std::shared_ptr<const CMergedMiningWork> mergedWork;    // Aux chains whose commitment the coinbase carries, if any
+};
+
+/** Merkle branch proving the first leaf (the coinbase) of vTxHashes' tree. */
+std::vector<uint256> ComputeStratumMerkleBranch(const std::vector<uint256>& vTxHashes);
+uint256 ComputeStratumMerkleRoot(const uint256& leaf, const std::vector<uint256>& vMerkleBranch);
+
+/**
+ * One unit of work as handed to miners. The coinbase split and merkle branch
+ * are computed once here and, with the lattice round table for hashPrevBlock,
+ * shared by every connection.
+ */
+class CStratumJob
+{
+public:
+    std::string id;
+    int32_t nVersion;
+    uint256 hashPrevBlock;
+    uint32_t nTime;
+    uint32_t nBits;
+    std::vector<unsigned char> coinb1;
+    std::vector<unsigned char> coinb2;
+    std::vector<uint256> vMerkleBranch;
+    LatticeRoundTable roundTable;
+    std::shared_ptr<const CMergedMiningWork> mergedWork;
+
+    CStratumJob(const std::string& idIn, const StratumTemplate& tmpl, const LatticeRoundTable& roundTableIn);
+    CStratumJob(const std::string& idIn, int32_t nVersionIn, const uint256& hashPrevBlockIn, uint32_t nTimeIn, uint32_t nBitsIn,
+                const std::vector<unsigned char>& coinb1In, const std::vector<unsigned char>& coinb2In,
+                const std::vector<uint256>& vMerkleBranchIn, const LatticeRoundTable& roundTableIn);
+
+    std::vector<unsigned char> GetCoinbase(const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2) const;
+    uint256 GetMerkleRoot(const std::vector<unsigned char>& extranonce1, const std::vector<unsigned char>& extranonce2) const;
+    void BuildHeader(const uint256& merkleRoot, uint32_t nTimeIn, uint32_t nNonce, unsigned char header[STRATUM_HEADER_SIZE]) const;
+    uint256 GetPoWHash(const unsigned char header[STRATUM_HEADER_SIZE]) const;
+
+    /** Duplicate-detection key: merkle root and nonce through SipHashUint256Extra, ntime folded into k0 */
+    uint64_t GetShareFingerprint(const unsigned char header[STRATUM_HEADER_SIZE]) const;
+    /** Accepted share fingerprints; created on first use, so miner-side jobs never allocate one */
+    CShareSet& GetShareSet();
+
+private:
+    uint64_t nShareKey0;
+    uint64_t nShareKey1;
+    std::mutex cs_submitted;
+    std::unique_ptr<CShareSet> setSubmitted;
+};
+
+/** Minimal fixed-size thread pool used for share validation. */
+class CStratumWorkQueue
+{
+public:
+    explicit CStratumWorkQueue(int nThreads);
+    ~CStratumWorkQueue();
+
+    void Enqueue(std::function<void()> func);
+    size_t Depth();
+
+private:
+    std::mutex cs;
+    std::condition_variable cond;
+    std::deque<std::function<void()>> queue;
+    std::vector<std::thread> threads;
+    bool fInterrupt;
+
+    void ThreadWorker();
+};
+
+struct StratumClient;
+
+/**
+ * Stratum-style TCP job server for local miner processes.
+ *
+ * Line-delimited JSON-RPC with mining.subscribe, mining.authorize and
+ * mining.submit. Jobs are pushed with mining.notify and the share target with
+ * mining.set_target. Hashes and coinbase parts are hex of the serialized bytes.
+ * Listens on the loopback interface only.
+ */
+class CStratumServer
+{
+public:
+    CStratumServer(const arith_uint256& shareTargetIn, int nThreads = DEFAULT_STRATUM_THREADS,
+                   int nPoWVersionIn = LATTICE_POW_VERSION_SINGLE);
+    ~CStratumServer();
+
+    bool Start(uint16_t nPort = DEFAULT_STRATUM_PORT);
+    void Stop();
+    uint16_t GetPort() const { return nListenPort; }
+
+    /** Cut a new job from tmpl and push it to every subscribed miner */
+    void NotifyTemplate(const StratumTemplate& tmpl, bool fCleanJobs);
+    /** Take job round tables from precomputer so a tip switch need not build one; set before Start() */
+    void SetPrecomputer(CLatticePrecomputer* precomputerIn) { precomputer = precomputerIn; }
+
+    /** Called from a validation thread when a share also meets the block target */
+    std::function<void(const CStratumJob& job, const unsigned char header[STRATUM_HEADER_SIZE])> BlockFound;
+
+    uint64_t GetSharesAccepted() const { return nSharesAccepted; }
+    uint64_t GetSharesRejected() const { return nSharesRejected; }
+    uint64_t GetBlocksFound() const { return nBlocksFound; }
+    size_t GetClientCount();
+    /** Submits waiting to be parsed plus shares waiting to be hashed */
+    size_t GetValidationQueueDepth();
+
+private:
+    const arith_uint256 shareTarget;
+    const int nPoWVersion;
+
+    SOCKET hListenSocket;
+    int wakeupPipe[2];
+    uint16_t nListenPort;
+    std::thread threadNet;
+    std::atomic<bool> fInterrupt;
+
+    std::mutex cs_clients;
+    std::map<SOCKET, std::shared_ptr<StratumClient>> mapClients;
+    uint32_t nNextExtraNonce1;
+
+    std::mutex cs_jobs;
+    std::deque<std::shared_ptr<CStratumJob>> vJobs;
+    uint64_t nJobSequence;
+    CLatticePrecomputer* precomputer;
+
+    std::atomic<uint64_t> nSharesAccepted;
+    std::atomic<uint64_t> nSharesRejected;
+    std::atomic<uint64_t> nBlocksFound;
+
+    std::unique_ptr<CShareValidator> shareValidator;
+
+    // Declared last so pending validations drain before other members go away
+    CStratumWorkQueue validationQueue;
+
+    void ThreadNet();
+    void AcceptConnection();
+    bool ReceiveFrom(const std::shared_ptr<StratumClient>& client);
+    void ProcessLine(const std::shared_ptr<StratumClient>& client, const std::string& line);
+    void ProcessSubmit(const std::shared_ptr<StratumClient>& client, const UniValue& id, const UniValue& params);
+    void SendJob(const std::shared_ptr<StratumClient>& client, const CStratumJob& job, bool fCleanJobs);
+    std::shared_ptr<CStratumJob> FindJob(const std::string& jobId);
+};
+
+/**
+ * Single-connection miner used to exercise the server over loopback.
+ * Searches nonces on the current job and submits every share it finds.
+ * nPoWVersion must match the server's, which notify does not carry.
+ */
+class CStratumLoopbackMiner
+{
+public:
+    explicit CStratumLoopbackMiner(int nPoWVersionIn = LATTICE_POW_VERSION_SINGLE);
+    ~CStratumLoopbackMiner();
+
+    bool Connect(uint16_t nPort);
+    /** Mine until fStop is set; returns false on protocol or connection errors */
+    bool Run(const std::atomic<bool>& fStop);
+
+    /** Optional throughput governor, paced as worker nGovernorWorker between nonce batches */
+    CMinerGovernor* governor;
+    int nGovernorWorker;
+    /** Optional source of round tables for new jobs, fed with candidate tips elsewhere */
+    CLatticePrecomputer* precomputer;
+
+    uint64_t nHashes;
+    uint64_t nSharesSubmitted;
+    uint64_t nSharesAccepted;
+    uint64_t nSharesRejected;
+
+private:
+    const int nPoWVersion;
+    SOCKET hSocket;
+    std::string recvBuffer;
+    std::vector<unsigned char> extranonce1;
+    arith_uint256 shareTarget;
+    std::shared_ptr<CStratumJob> job;
+    LatticeTipState tip;                                // Of job's hashPrevBlock
+    uint32_t nExtraNonce2;
+    uint32_t nNonce;
+    int nNextRequestId;
+
+    bool SendRequest(const std::string& method, const UniValue& params);
+    bool PollMessages(bool fBlock);
+    bool ProcessLine(const std::string& line);
+};
+
+#endif // LATTICE_STRATUM_H
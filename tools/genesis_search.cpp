@@ -0,0 +1,256 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Resumable genesis block nonce search.
+//
+// Usage: genesis_search -merkle=<hex> [-time=<n>] [-bits=<hex>] [-version=<n>] [-prev=<hex>]
+//                       [-powversion=<n>] [-matrixseed=<hex>] [-threads=<n>] [-start=<nonce>]
+//                       [-end=<nonce>] [-checkpoint=<path>] [-interval=<seconds>] [-placement=<policy>]
+//
+// -matrixseed is the InitializeLatticeMatrix seed the chain uses for the
+// v1/v2 matrix; it defaults to the genesis procedure's seed.
+//
+// Progress is checkpointed every interval and on SIGINT/SIGTERM. Started
+// again with the same checkpoint, the search continues where each worker
+// stopped; parameters given on the command line must match the checkpoint.
+
+#define GLOBALDEFINED
+#include "arith_uint256.h"
+#include "genesissearch.h"
+#include "latticeplacement.h"
+#include "latticetune.h"
+#include "minerchannel.h"
+#include "util.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <thread>
+
+static std::atomic<bool> fRequestShutdown(false);
+
+static void HandleSignal(int)
+{
+    fRequestShutdown = true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> mapArgs;
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        size_t pos = str.find('=');
+        if (str.size() < 2 || str[0] != '-' || pos == std::string::npos) {
+            std::cerr << "Unexpected argument " << str << std::endl;
+            return 1;
+        }
+        mapArgs[str.substr(1, pos - 1)] = str.substr(pos + 1);
+    }
+    auto arg = [&](const std::string& key, const std::string& strDefault) {
+        return mapArgs.count(key) ? mapArgs[key] : strDefault;
+    };
+
+    GenesisSearchParams params;
+    params.nVersion = atoi(arg("version", "4").c_str());
+    params.hashPrevBlock = uint256S(arg("prev", "0"));
+    params.hashMerkleRoot = uint256S(arg("merkle", "0"));
+    params.nTime = strtoul(arg("time", "1524179366").c_str(), nullptr, 10);
+    params.nBits = strtoul(arg("bits", "207fffff").c_str(), nullptr, 16);
+    params.nPoWVersion = atoi(arg("powversion", "1").c_str());
+    params.matrixSeed = uint256S(arg("matrixseed", LATTICE_MATRIX_DEFAULT_SEED));
+    int nThreads = atoi(arg("threads", std::to_string(std::max(1u, std::thread::hardware_concurrency()))).c_str());
+    uint64_t nStart = strtoull(arg("start", "0").c_str(), nullptr, 10);
+    uint64_t nEnd = std::min<uint64_t>(strtoull(arg("end", std::to_string(GENESIS_NONCE_LIMIT)).c_str(), nullptr, 10), GENESIS_NONCE_LIMIT);
+    std::string strCheckpoint = arg("checkpoint", DEFAULT_GENESIS_CHECKPOINT);
+    int64_t nInterval = strtoll(arg("interval", std::to_string(DEFAULT_GENESIS_CHECKPOINT_SECONDS)).c_str(), nullptr, 10);
+    PlacementPolicy placementPolicy = DEFAULT_PLACEMENT_POLICY;
+    if (!ParsePlacementPolicy(arg("placement", GetPlacementPolicyName(placementPolicy)), placementPolicy)) {
+        std::cerr << "Unknown placement policy " << arg("placement", "") << std::endl;
+        return 1;
+    }
+
+    GenesisCheckpoint checkpoint;
+    std::string strError;
+    if (std::ifstream(strCheckpoint).good()) {
+        if (!ReadGenesisCheckpoint(strCheckpoint, checkpoint, strError)) {
+            std::cerr << "Cannot resume from " << strCheckpoint << ": " << strError << std::endl;
+            return 1;
+        }
+        // Whatever was not given explicitly comes from the checkpoint
+        bool fExplicit = mapArgs.count("version") || mapArgs.count("prev") || mapArgs.count("merkle") ||
+                         mapArgs.count("time") || mapArgs.count("bits") || mapArgs.count("powversion") ||
+                         mapArgs.count("matrixseed");
+        if (fExplicit && params != checkpoint.params) {
+            std::cerr << strCheckpoint << " was written for different parameters; remove it or pass another -checkpoint" << std::endl;
+            return 1;
+        }
+        params = checkpoint.params;
+        std::cout << "Resuming from " << strCheckpoint << ": " << checkpoint.GetSearched() << " nonces searched, "
+                  << checkpoint.GetRemaining() << " left in " << checkpoint.vRanges.size() << " ranges" << std::endl;
+    } else {
+        if (!mapArgs.count("merkle")) {
+            std::cerr << "-merkle is required for a new search" << std::endl;
+            return 1;
+        }
+        checkpoint.params = params;
+        checkpoint.vRanges = SplitGenesisRange(nStart, nEnd, nThreads);
+    }
+
+    bool fNegative, fOverflow;
+    arith_uint256 target;
+    target.SetCompact(params.nBits, &fNegative, &fOverflow);
+    if (fNegative || fOverflow || target == 0) {
+        std::cerr << "Invalid nBits" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Genesis search: version " << params.nVersion << ", time " << params.nTime << ", bits "
+              << strprintf("%08x", params.nBits) << ", PoW version " << params.nPoWVersion << std::endl;
+    std::cout << "Merkle root: " << params.hashMerkleRoot.GetHex() << std::endl;
+    std::cout << "Matrix seed: " << params.matrixSeed.GetHex() << std::endl;
+
+    // Before any round table: tables copy the backend, and v1/v2 tables
+    // point at the matrix this seeds
+    std::cout << "Lattice backend: " << LatticeAutoTune(DEFAULT_LATTICE_TUNE_FILE) << std::endl;
+    InitializeLatticeMatrix(params.matrixSeed);
+
+    if (!checkpoint.fFound && checkpoint.GetRemaining() > 0) {
+        std::signal(SIGINT, HandleSignal);
+        std::signal(SIGTERM, HandleSignal);
+        SetWorkerPlacement(placementPolicy);
+
+        LatticeRoundTable table;
+        BuildLatticeRoundTable(params.hashPrevBlock, params.nPoWVersion, table);
+
+        // Each checkpoint range is one worker, so resuming keeps the split
+        int nWorkers = checkpoint.vRanges.size();
+        CMinerResultChannel channel(nWorkers);
+        std::unique_ptr<std::atomic<uint64_t>[]> vNext(new std::atomic<uint64_t>[nWorkers]);
+        for (int i = 0; i < nWorkers; i++) {
+            vNext[i] = checkpoint.vRanges[i].nNext;
+        }
+        std::atomic<bool> fStop(false);
+        std::atomic<int> nRunning(nWorkers);
+        std::vector<std::thread> vThreads;
+        for (int w = 0; w < nWorkers; w++) {
+            vThreads.emplace_back([w, &params, &table, &target, &channel, &vNext, &checkpoint, &fStop, &nRunning] {
+                RenameThread(strprintf("genesis-%d", w).c_str());
+                CWorkerPlacement placement;
+                LatticeRoundTable localTable = table;
+                placement.LocalizeRoundTable(localTable);
+                CMinerReporter reporter(channel, w, target);
+                unsigned char header[BLOCK_HEADER_SIZE];
+                BuildGenesisHeader(params, 0, header);
+
+                uint64_t nNext = vNext[w].load(std::memory_order_relaxed);
+                uint64_t nEnd = checkpoint.vRanges[w].nEnd;
+                while (!fStop && nNext < nEnd) {
+                    uint64_t nBatchEnd = std::min<uint64_t>(nNext + GENESIS_BATCH_SIZE, nEnd);
+                    for (uint64_t n = nNext; n < nBatchEnd; n++) {
+                        WriteLE32(header + 76, (uint32_t)n);
+                        reporter.Hash(header, (uint32_t)n, HashLatticePOW(header, header + BLOCK_HEADER_SIZE, localTable));
+                    }
+                    reporter.Flush();
+                    // Published after the batch's results, so a checkpoint
+                    // never records a nonce whose solution is still unseen
+                    nNext = nBatchEnd;
+                    vNext[w].store(nNext, std::memory_order_release);
+                }
+                nRunning--;
+            });
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        auto next_checkpoint = start_time + std::chrono::seconds(nInterval);
+        int64_t nElapsedBefore = checkpoint.nElapsedMillis;
+        uint64_t nSearchedBefore = checkpoint.GetSearched();
+        arith_uint256 best = checkpoint.fBest ? UintToArith256(checkpoint.bestHash) : ~arith_uint256(0);
+        std::vector<MinerResult> vResults;
+
+        // Positions first, then the channel: everything behind a published
+        // position is already in the rings
+        auto snapshot = [&] {
+            for (int i = 0; i < nWorkers; i++) {
+                checkpoint.vRanges[i].nNext = vNext[i].load(std::memory_order_acquire);
+            }
+            vResults.clear();
+            channel.Drain(vResults);
+            for (const MinerResult& result : vResults) {
+                if (result.type == MINER_RESULT_STATS)
+                    continue;
+                arith_uint256 bnHash = UintToArith256(result.hash);
+                if (bnHash < best) {
+                    best = bnHash;
+                    checkpoint.fBest = true;
+                    checkpoint.bestHash = result.hash;
+                    checkpoint.nBestNonce = result.nNonce;
+                    std::cout << "New best: " << result.hash.GetHex() << " Nonce: " << result.nNonce << std::endl;
+                }
+                if (result.type == MINER_RESULT_SOLUTION && !checkpoint.fFound) {
+                    checkpoint.fFound = true;
+                    checkpoint.nFoundNonce = result.nNonce;
+                    fStop = true;
+                }
+            }
+            checkpoint.nElapsedMillis = nElapsedBefore + std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                             std::chrono::steady_clock::now() - start_time).count();
+        };
+        auto progress = [&] {
+            double nSeconds = (checkpoint.nElapsedMillis - nElapsedBefore) / 1000.0;
+            std::cout << "Progress: " << checkpoint.GetSearched() << " searched, " << checkpoint.GetRemaining() << " left ("
+                      << std::fixed << std::setprecision(2) << (checkpoint.GetSearched() - nSearchedBefore) / std::max(nSeconds, 0.001)
+                      << " H/s) Best: " << (checkpoint.fBest ? checkpoint.bestHash.GetHex().substr(0, 16) : "none") << "..." << std::endl;
+        };
+
+        while (nRunning > 0) {
+            if (fRequestShutdown)
+                fStop = true;
+            channel.WaitForResults(200000);
+            snapshot();
+            if (std::chrono::steady_clock::now() >= next_checkpoint) {
+                WriteGenesisCheckpoint(strCheckpoint, checkpoint);
+                progress();
+                next_checkpoint += std::chrono::seconds(nInterval);
+            }
+        }
+        for (std::thread& thread : vThreads) {
+            thread.join();
+        }
+        snapshot();
+        if (!WriteGenesisCheckpoint(strCheckpoint, checkpoint)) {
+            std::cerr << "Failed to write final checkpoint " << strCheckpoint << std::endl;
+        }
+        progress();
+        if (fRequestShutdown && !checkpoint.fFound) {
+            std::cout << "Interrupted; run again with -checkpoint=" << strCheckpoint << " to resume" << std::endl;
+            return 0;
+        }
+    }
+
+    if (!checkpoint.fFound) {
+        std::cout << "No nonce in the searched range meets the target; change -time or the coinbase and search again" << std::endl;
+        return 1;
+    }
+
+    unsigned char header[BLOCK_HEADER_SIZE];
+    BuildGenesisHeader(params, checkpoint.nFoundNonce, header);
+    LatticeRoundTable table;
+    BuildLatticeRoundTable(params.hashPrevBlock, params.nPoWVersion, table);
+    uint256 hash = HashLatticePOW(header, header + BLOCK_HEADER_SIZE, table);
+
+    std::cout << std::endl << "=== LATTICE-PoW Genesis Search Results ===" << std::endl;
+    std::cout << "hashGenesisBlock: 0x" << hash.GetHex() << std::endl;
+    std::cout << "Genesis Nonce: " << checkpoint.nFoundNonce << std::endl;
+    std::cout << "Genesis Merkle: " << params.hashMerkleRoot.GetHex() << std::endl;
+    std::cout << "Total search time: " << checkpoint.nElapsedMillis / 1000 << " seconds" << std::endl;
+    std::cout << std::endl << "=== Copy these values to your chainparams.cpp ===" << std::endl;
+    std::cout << "consensus.hashGenesisBlock = uint256S(\"0x" << hash.GetHex() << "\");" << std::endl;
+    std::cout << "genesis.nNonce = " << checkpoint.nFoundNonce << ";" << std::endl;
+    std::cout << "genesis.hashMerkleRoot = uint256S(\"0x" << params.hashMerkleRoot.GetHex() << "\");" << std::endl;
+    return 0;
+}
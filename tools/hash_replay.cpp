@@ -0,0 +1,219 @@
+// Copyright (c) 2025 LATTICE-PoW developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Replays a hash trace captured with StartHashTrace through this build.
+//
+// Usage: hash_replay -trace=<path> [-threads=<n>] [-repeat=<n>]
+//
+// The whole trace is loaded and every round table it uses is built before
+// timing starts. Records are then hashed in capture order at full speed,
+// split across the threads in blocks of HASH_REPLAY_BLOCK, -repeat times
+// over. The mixed run is followed by one run per record type for ns/op.
+//
+// Every result is compared against the one recorded at capture, so the
+// replay doubles as a bit-exactness check for optimizations. The v1/v2
+// lattice matrix, which lattice256 also hashes through, is initialized with
+// the seed the capturing process used.
+
+#define GLOBALDEFINED
+#include "hash.h"
+#include "hashtrace.h"
+#include "latticetune.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+
+static const size_t HASH_REPLAY_BLOCK = 256;
+
+/** A record with everything it needs resolved, so replay only hashes */
+struct ReplayItem {
+    HashTraceType type;
+    const unsigned char* data;
+    size_t len;
+    uint64_t nCheck;
+    const LatticeRoundTable* table;
+    const std::vector<unsigned char>* vMurmur;
+};
+
+struct ReplayCounts {
+    uint64_t nOps[NUM_HASH_TRACE_TYPES];
+    uint64_t nBytes[NUM_HASH_TRACE_TYPES];
+    uint64_t nMismatches[NUM_HASH_TRACE_TYPES];
+
+    ReplayCounts() { memset(this, 0, sizeof(*this)); }
+};
+
+static uint64_t ReplayOne(const ReplayItem& item)
+{
+    switch (item.type) {
+    case HASH_TRACE_LATTICE_POW:
+        return HashLatticePOW(item.data, item.data + item.len, *item.table).GetUint64(0);
+    case HASH_TRACE_LATTICE256: {
+        unsigned char hash[CHashLattice256::OUTPUT_SIZE];
+        LatticeHash256(item.data, item.len, hash);
+        return ReadLE64(hash);
+    }
+    case HASH_TRACE_HASH160:
+        return ReadLE64(Hash160(item.data, item.data + item.len).begin());
+    case HASH_TRACE_SIPHASH:
+    case HASH_TRACE_SIPHASH_EXTRA: {
+        uint256 val;
+        memcpy(val.begin(), item.data + 16, 32);
+        uint64_t k0 = ReadLE64(item.data), k1 = ReadLE64(item.data + 8);
+        if (item.type == HASH_TRACE_SIPHASH)
+            return SipHashUint256(k0, k1, val);
+        return SipHashUint256Extra(k0, k1, val, ReadLE32(item.data + 48));
+    }
+    case HASH_TRACE_MURMUR3:
+        return MurmurHash3(ReadLE32(item.data), *item.vMurmur);
+    default:
+        return 0;
+    }
+}
+
+/** Hash vItems, -repeat times, across nThreads; returns wall seconds */
+static double Replay(const std::vector<ReplayItem>& vItems, int nThreads, int nRepeat, ReplayCounts& total)
+{
+    std::vector<ReplayCounts> vCounts(nThreads);
+    std::vector<std::thread> vThreads;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int t = 0; t < nThreads; t++) {
+        vThreads.emplace_back([t, nThreads, nRepeat, &vItems, &vCounts] {
+            RenameThread(strprintf("replay-%d", t).c_str());
+            ReplayCounts& counts = vCounts[t];
+            for (int r = 0; r < nRepeat; r++) {
+                for (size_t nBlock = t * HASH_REPLAY_BLOCK; nBlock < vItems.size(); nBlock += nThreads * HASH_REPLAY_BLOCK) {
+                    size_t nEnd = std::min(nBlock + HASH_REPLAY_BLOCK, vItems.size());
+                    for (size_t i = nBlock; i < nEnd; i++) {
+                        const ReplayItem& item = vItems[i];
+                        if (ReplayOne(item) != item.nCheck)
+                            counts.nMismatches[item.type]++;
+                        counts.nOps[item.type]++;
+                        counts.nBytes[item.type] += item.len;
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& thread : vThreads) {
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    total = ReplayCounts();
+    for (const ReplayCounts& counts : vCounts) {
+        for (int i = 0; i < NUM_HASH_TRACE_TYPES; i++) {
+            total.nOps[i] += counts.nOps[i];
+            total.nBytes[i] += counts.nBytes[i];
+            total.nMismatches[i] += counts.nMismatches[i];
+        }
+    }
+    return elapsed;
+}
+
+int main(int argc, char* argv[])
+{
+    std::map<std::string, std::string> mapArgs;
+    for (int i = 1; i < argc; i++) {
+        std::string str = argv[i];
+        size_t pos = str.find('=');
+        if (str.size() < 2 || str[0] != '-' || pos == std::string::npos) {
+            std::cerr << "Unexpected argument " << str << std::endl;
+            return 1;
+        }
+        mapArgs[str.substr(1, pos - 1)] = str.substr(pos + 1);
+    }
+    if (!mapArgs.count("trace")) {
+        std::cerr << "Usage: hash_replay -trace=<path> [-threads=<n>] [-repeat=<n>]" << std::endl;
+        return 1;
+    }
+    int nThreads = std::max(1, mapArgs.count("threads") ? atoi(mapArgs["threads"].c_str()) : 1);
+    int nRepeat = std::max(1, mapArgs.count("repeat") ? atoi(mapArgs["repeat"].c_str()) : 1);
+
+    // Before the round tables below, which copy the installed backend
+    std::cout << "Lattice backend: " << LatticeAutoTune(DEFAULT_LATTICE_TUNE_FILE) << std::endl;
+
+    HashTraceFile trace;
+    std::string strError;
+    if (!ReadHashTrace(mapArgs["trace"], trace, strError)) {
+        std::cerr << "Cannot read " << mapArgs["trace"] << ": " << strError << std::endl;
+        return 1;
+    }
+
+    // Before any round table, which would otherwise seed the matrix itself
+    if (trace.fMatrixSeed)
+        InitializeLatticeMatrix(trace.matrixSeed);
+
+    // Resolve round tables and murmur inputs up front
+    std::map<std::pair<int, uint256>, std::unique_ptr<LatticeRoundTable>> mapTables;
+    std::vector<std::unique_ptr<std::vector<unsigned char>>> vMurmurInputs;
+    std::vector<ReplayItem> vItems;
+    vItems.reserve(trace.vRecords.size());
+    for (const HashTraceRecord& record : trace.vRecords) {
+        ReplayItem item;
+        item.type = record.type;
+        item.data = trace.vData.data() + record.nOffset;
+        item.len = record.nLength;
+        item.nCheck = record.nCheck;
+        item.table = nullptr;
+        item.vMurmur = nullptr;
+        if (record.type == HASH_TRACE_LATTICE_POW) {
+            std::unique_ptr<LatticeRoundTable>& table = mapTables[std::make_pair(record.nPowVersion, record.hashPrevBlock)];
+            if (!table) {
+                table.reset(new LatticeRoundTable());
+                BuildLatticeRoundTable(record.hashPrevBlock, record.nPowVersion, *table);
+            }
+            item.table = table.get();
+        } else if (record.type == HASH_TRACE_MURMUR3) {
+            vMurmurInputs.emplace_back(new std::vector<unsigned char>(item.data + 4, item.data + item.len));
+            item.vMurmur = vMurmurInputs.back().get();
+        }
+        vItems.push_back(item);
+    }
+
+    std::cout << "=== LATTICE-PoW Hash Trace Replay ===" << std::endl;
+    std::cout << "Trace: " << mapArgs["trace"] << ", " << trace.vData.size() << " bytes, " << vItems.size() << " calls, "
+              << mapTables.size() << " round tables" << std::endl;
+    std::cout << "Threads: " << nThreads << ", passes: " << nRepeat << std::endl;
+
+    ReplayCounts mixed;
+    double elapsed = Replay(vItems, nThreads, nRepeat, mixed);
+    uint64_t nOps = 0, nMismatches = 0;
+    for (int i = 0; i < NUM_HASH_TRACE_TYPES; i++) {
+        nOps += mixed.nOps[i];
+        nMismatches += mixed.nMismatches[i];
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Mixed: " << nOps / std::max(elapsed, 1e-9) << " calls/s over " << elapsed << " s" << std::endl;
+
+    // Per type, the same records in isolation
+    std::cout << std::left << std::setw(16) << "type" << std::right << std::setw(12) << "calls" << std::setw(14) << "avg bytes"
+              << std::setw(14) << "ns/call" << std::setw(16) << "calls/s" << std::setw(12) << "mismatch" << std::endl;
+    for (int type = HASH_TRACE_LATTICE_POW; type < NUM_HASH_TRACE_TYPES; type++) {
+        if (mixed.nOps[type] == 0)
+            continue;
+        std::vector<ReplayItem> vType;
+        for (const ReplayItem& item : vItems) {
+            if (item.type == type)
+                vType.push_back(item);
+        }
+        ReplayCounts counts;
+        double nSeconds = Replay(vType, nThreads, nRepeat, counts);
+        std::cout << std::left << std::setw(16) << GetHashTraceTypeName((HashTraceType)type) << std::right
+                  << std::setw(12) << vType.size() << std::setw(14) << (double)counts.nBytes[type] / counts.nOps[type]
+                  << std::setw(14) << nSeconds * 1e9 * nThreads / counts.nOps[type]
+                  << std::setw(16) << counts.nOps[type] / std::max(nSeconds, 1e-9)
+                  << std::setw(12) << mixed.nMismatches[type] << std::endl;
+    }
+    if (nMismatches > 0) {
+        std::cout << nMismatches << " results differ from the capture" << std::endl;
+        return 2;
+    }
+    return 0;
+}